@@ -1,2 +1,4 @@
 /usr/local/bin/glslc shaders/simple.vert -o shaders/simple.vert.spv
 /usr/local/bin/glslc shaders/simple.frag -o shaders/simple.frag.spv
+/usr/local/bin/glslc shaders/indirect.vert -o shaders/indirect.vert.spv
+/usr/local/bin/glslc shaders/cull.comp -o shaders/cull.comp.spv
@@ -0,0 +1,25 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+
+layout(location = 0) out vec3 fragColor;
+
+struct ObjectData
+{
+    mat4 transform;
+    vec4 boundingSphere;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects { ObjectData objects[]; };
+
+layout(push_constant) uniform Constants
+{
+    mat4 viewProjection;
+} constants;
+
+void main()
+{
+    gl_Position = constants.viewProjection * objects[gl_InstanceIndex].transform * vec4(position, 1.0);
+    fragColor = color;
+}
@@ -1,8 +1,19 @@
 #version 450
 
+layout(location = 0) in vec3 fragColor;
+
 layout(location = 0) out vec4 FragColor;
 
+// specialized per pipeline variant, see ShaderFeature
+layout(constant_id = 0) const bool VERTEX_COLOR = true;
+layout(constant_id = 1) const bool GRAYSCALE = false;
+
 void main()
 {
-    FragColor = vec4(1.0, 0.0, 0.0, 1.0);
+    vec3 color = VERTEX_COLOR ? fragColor : vec3(1.0);
+
+    if(GRAYSCALE)
+        color = vec3(dot(color, vec3(0.2126, 0.7152, 0.0722)));
+
+    FragColor = vec4(color, 1.0);
 }
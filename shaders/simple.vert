@@ -1,12 +1,18 @@
 #version 450
 
-vec2 positions[3] = vec2[](
-    vec2( 0.0, -0.5),
-    vec2( 0.5,  0.5),
-    vec2(-0.5,  0.5)
-);
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+
+layout(location = 0) out vec3 fragColor;
+
+// one block per draw, selected through a dynamic offset
+layout(set = 0, binding = 0) uniform DrawData
+{
+    mat4 modelViewProjection;
+} draw;
 
 void main()
 {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
+    gl_Position = draw.modelViewProjection * vec4(position, 1.0);
+    fragColor = color;
 }
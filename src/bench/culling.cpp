@@ -0,0 +1,150 @@
+#include "core/Scene.hpp"
+#include "core/SceneCuller.hpp"
+#include "core/ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Throughput of the CPU side scene work in objects per second: writing the transforms and culling,
+ * single threaded and across the thread pool. Needs no GPU, prints the results as JSON to stdout.
+ */
+
+namespace
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    struct Samples
+    {
+        std::map<std::string, std::vector<double>> stages;
+
+        void add(const std::string& stage, double ms) { stages[stage].push_back(ms); }
+    };
+
+    // random objects in a cube around the camera, roughly a quarter of them in view
+    void fillScene(Scene& scene, uint32_t objectCount)
+    {
+        std::mt19937 random{ 42 };
+        std::uniform_real_distribution<float> position{ -100.f, 100.f };
+        std::uniform_real_distribution<float> unit{ -1.f, 1.f };
+        std::uniform_real_distribution<float> scale{ 0.5f, 2.f };
+
+        scene.reserve(objectCount);
+        for(uint32_t i{ 0 }; i < objectCount; ++i)
+        {
+            glm::quat rotation{ glm::normalize(glm::quat{ unit(random), unit(random), unit(random), unit(random) }) };
+            Transform transform{ .position = { position(random), position(random), position(random) }, .rotation = rotation, .scale = glm::vec3{ scale(random) } };
+            scene.create(transform, glm::vec4{ 0.f, 0.f, 0.f, 1.f }, Renderable{ .pipeline = nullptr, .model = nullptr });
+        }
+    }
+
+    template<typename F>
+    void measure(Samples& samples, const std::string& stage, F&& function)
+    {
+        auto start{ std::chrono::steady_clock::now() };
+        function();
+        samples.add(stage, Milliseconds(std::chrono::steady_clock::now() - start).count());
+    }
+
+    void writeJson(const Samples& samples, uint32_t objectCount, uint32_t repetitions, uint32_t threads, size_t visible)
+    {
+        std::cout << "{\n  \"objects\": " << objectCount << ",\n  \"repetitions\": " << repetitions << ",\n  \"threads\": " << threads <<
+            ",\n  \"visible\": " << visible << ",\n  \"stages\": {";
+
+        bool first{ true };
+        for(auto [stage, values]: samples.stages)
+        {
+            std::sort(values.begin(), values.end());
+            double median{ values[values.size() / 2] };
+            double avg{ std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size()) };
+
+            std::cout << (first ? "\n" : ",\n") << "    \"" << stage << "\": { \"min\": " << values.front() <<
+                ", \"median\": " << median <<
+                ", \"avg\": " << avg <<
+                ", \"max\": " << values.back() <<
+                ", \"objectsPerSecond\": " << static_cast<double>(objectCount) / (median / 1000.0) << " }";
+            first = false;
+        }
+
+        std::cout << "\n  }\n}" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t objectCount{ 100000 };
+    uint32_t repetitions{ 100 };
+    uint32_t threads{ ThreadPool::defaultThreadCount() };
+
+    for(int i{ 1 }; i < argc; ++i)
+    {
+        std::string_view arg{ argv[i] };
+
+        if(arg == "--objects" && i + 1 < argc)
+            objectCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else if(arg == "--repetitions" && i + 1 < argc)
+            repetitions = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else if(arg == "--threads" && i + 1 < argc)
+            threads = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--objects N] [--repetitions N] [--threads N]" << std::endl;
+            return 1;
+        }
+    }
+
+    try
+    {
+        ThreadPool threadPool{ threads };
+        Scene scene;
+        fillScene(scene, objectCount);
+
+        glm::mat4 projection{ glm::perspectiveRH_ZO(glm::radians(60.f), 16.f / 9.f, 0.1f, 1000.f) };
+        projection[1][1] *= -1.f;
+        CullView view{
+            .frustum = Frustum::fromViewProjection(projection * glm::lookAt(glm::vec3{ 0.f }, glm::vec3{ 0.f, 0.f, -1.f }, glm::vec3{ 0.f, 1.f, 0.f })),
+            .maxDistance = 150.f
+        };
+
+        SceneCuller culler{ threadPool };
+        std::vector<uint32_t> visible;
+        std::vector<ObjectData> objects(scene.size());
+        Samples samples;
+
+        for(uint32_t i{ 0 }; i < repetitions; ++i)
+        {
+            measure(samples, "writeObjects", [&] { scene.writeObjects(objects.data(), 0, scene.size()); });
+            measure(samples, "writeObjectsParallel", [&] { scene.writeObjects(objects.data(), threadPool); });
+
+            visible.clear();
+            measure(samples, "cull", [&] { SceneCuller::cullRange(scene, view, 0, scene.size(), visible); });
+            measure(samples, "cullParallel", [&] { culler.cull(scene, view); });
+        }
+
+        if(visible != culler.visible())
+            throw std::runtime_error("Failure while culling: the parallel result differs from the single threaded one");
+
+        writeJson(samples, objectCount, repetitions, threads, visible.size());
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::exit(1);
+    }
+
+    return 0;
+}
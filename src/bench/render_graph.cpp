@@ -0,0 +1,204 @@
+#include "core/Device.hpp"
+#include "core/RenderGraph.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Compiles a deferred style frame through the render graph and executes it once on a headless device.
+ * The frame exercises what the single pass swapchain graph never does: a culled pass, input attachments,
+ * a depth buffer preserved across passes that don't touch it and transients of different formats aliased
+ * onto the same memory. The compiled structure is checked against what the graph has to derive,
+ * built with validation layers so the layers report whatever the checks miss. Prints the results as JSON to stdout.
+ */
+
+namespace
+{
+    constexpr VkExtent2D EXTENT{ 800, 600 };
+    constexpr VkFormat COLOR_FORMAT{ VK_FORMAT_R8G8B8A8_UNORM };
+
+    void check(bool condition, const std::string& what)
+    {
+        if(!condition)
+            throw std::runtime_error("Failure while checking render graph: " + what);
+    }
+
+    const VkSubpassDependency* findDependency(const RenderGraph& graph, uint32_t src, uint32_t dst)
+    {
+        const auto& dependencies{ graph.dependencies() };
+        auto it{ std::find_if(dependencies.begin(), dependencies.end(), [&](const VkSubpassDependency& dependency) {
+            return dependency.srcSubpass == src && dependency.dstSubpass == dst;
+        }) };
+
+        return it == dependencies.end() ? nullptr : &*it;
+    }
+
+    void declareFrame(RenderGraph& graph, VkFormat depthFormat)
+    {
+        RenderResource color{ graph.importAttachment("color", COLOR_FORMAT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VkClearValue{ .color = { 0.f, 0.f, 0.f, 1.f } }) };
+        RenderResource depth{ graph.createAttachment("depth", depthFormat, VkClearValue{ .depthStencil = { 1.f, 0 } }) };
+        RenderResource albedo{ graph.createAttachment("albedo", VK_FORMAT_R16G16B16A16_SFLOAT, VkClearValue{}) };
+        RenderResource normal{ graph.createAttachment("normal", VK_FORMAT_R16G16B16A16_SFLOAT, VkClearValue{}) };
+        RenderResource hdr{ graph.createAttachment("hdr", VK_FORMAT_R16G16B16A16_SFLOAT) };
+        RenderResource ldr{ graph.createAttachment("ldr", COLOR_FORMAT) };
+        RenderResource debug{ graph.createAttachment("debug", COLOR_FORMAT, VkClearValue{}) };
+
+        graph.addPass("gbuffer").writeColor(albedo).writeColor(normal).writeDepth(depth);
+        graph.addPass("lighting").readInput(albedo).readInput(normal).writeColor(hdr);
+        // nothing reads what it writes
+        graph.addPass("debug").writeColor(debug);
+        // ldr starts after albedo's last use, so it takes over albedo's memory despite the different format
+        graph.addPass("tonemap").readInput(hdr).writeColor(ldr);
+        // depth tested again without the passes in between touching it
+        graph.addPass("overlay").readInput(ldr).readDepth(depth).writeColor(color);
+    }
+
+    void checkStructure(const RenderGraph& graph)
+    {
+        check(graph.isCulled("debug"), "the debug pass survived");
+        check(graph.subpass("gbuffer") == 0 && graph.subpass("lighting") == 1 && graph.subpass("tonemap") == 2 && graph.subpass("overlay") == 3, "unexpected subpass order");
+        // color and the five transients the surviving passes use
+        check(graph.clearValues().size() == 6, "unexpected attachment count");
+        // albedo and ldr share, normal, depth and hdr overlap everything else
+        check(graph.aliasGroupCount() == 4, "unexpected alias group count");
+
+        const VkSubpassDependency* gbufferToLighting{ findDependency(graph, 0, 1) };
+        check(gbufferToLighting && (gbufferToLighting->dependencyFlags & VK_DEPENDENCY_BY_REGION_BIT), "the input attachment dependency is missing or not by region");
+
+        const VkSubpassDependency* handoff{ findDependency(graph, 1, 2) };
+        check(handoff && !(handoff->dependencyFlags & VK_DEPENDENCY_BY_REGION_BIT), "the aliasing handoff is missing or by region");
+
+        const VkSubpassDependency* preservedDepth{ findDependency(graph, 0, 3) };
+        check(preservedDepth && (preservedDepth->dstAccessMask & VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT), "the preserved depth is not ordered before its read");
+    }
+
+    // records the frame without draws, the layers still validate the layouts, load ops and dependencies
+    void execute(Device& device, const RenderGraph& graph, VkRenderPass renderPass, const RenderTargets& targets)
+    {
+        VkImageCreateInfo imageInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = COLOR_FORMAT,
+            .extent = VkExtent3D{ .width = EXTENT.width, .height = EXTENT.height, .depth = 1 },
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+        };
+
+        VkImage colorImage;
+        MemoryAllocation colorMemory;
+        device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImage, colorMemory);
+
+        VkImageViewCreateInfo viewInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = colorImage,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = COLOR_FORMAT,
+            .subresourceRange = VkImageSubresourceRange{
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            }
+        };
+
+        VkImageView colorView;
+        if(vkCreateImageView(device.device(), &viewInfo, nullptr, &colorView) != VK_SUCCESS)
+            throw std::runtime_error("Failure while creating color image view");
+
+        std::vector<VkImageView> attachments{ graph.framebufferAttachments(targets, 0, { colorView }) };
+        VkFramebufferCreateInfo framebufferInfo{
+            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+            .renderPass = renderPass,
+            .attachmentCount = static_cast<uint32_t>(attachments.size()),
+            .pAttachments = attachments.data(),
+            .width = EXTENT.width,
+            .height = EXTENT.height,
+            .layers = 1
+        };
+
+        VkFramebuffer framebuffer;
+        if(vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS)
+            throw std::runtime_error("Failure while creating framebuffer");
+
+        VkRenderPassBeginInfo beginInfo{
+            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+            .renderPass = renderPass,
+            .framebuffer = framebuffer,
+            .renderArea = VkRect2D{ .offset = { 0, 0 }, .extent = EXTENT },
+            .clearValueCount = static_cast<uint32_t>(graph.clearValues().size()),
+            .pClearValues = graph.clearValues().data()
+        };
+
+        VkCommandBuffer commandBuffer{ device.beginSingleTimeCommand() };
+        vkCmdBeginRenderPass(commandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        for(uint32_t subpass{ 1 }; subpass <= graph.subpass("overlay"); ++subpass)
+            vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdEndRenderPass(commandBuffer);
+        device.endSingleTimeCommands(commandBuffer);
+
+        vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+        vkDestroyImageView(device.device(), colorView, nullptr);
+        device.destroyImage(colorImage, colorMemory);
+    }
+
+    void writeJson(const RenderGraph& graph, const RenderTargets& targets)
+    {
+        std::cout << "{\n  \"subpasses\": " << graph.subpass("overlay") + 1 <<
+            ",\n  \"attachments\": " << graph.clearValues().size() <<
+            ",\n  \"aliasGroups\": " << graph.aliasGroupCount() <<
+            ",\n  \"dependencies\": " << graph.dependencies().size() <<
+            ",\n  \"transientBytes\": " << targets.bytes <<
+            ",\n  \"aliasedBytes\": " << targets.aliasedBytes <<
+            ",\n  \"lazilyAllocated\": " << (targets.lazilyAllocated ? "true" : "false") << "\n}" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if(argc > 1)
+    {
+        std::cerr << "usage: " << argv[0] << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        // headless and without writing a pipeline cache
+        Device device{ nullptr, "" };
+        VkFormat depthFormat{ device.findSupportedFormat({ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+            VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) };
+
+        RenderGraph graph;
+        declareFrame(graph, depthFormat);
+        VkRenderPass renderPass{ graph.compile(device.device()) };
+        checkStructure(graph);
+
+        RenderTargets targets{ graph.createTargets(device, EXTENT, 1) };
+        check(targets.aliasedBytes > 0, "aliasing saved no memory");
+
+        execute(device, graph, renderPass, targets);
+        writeJson(graph, targets);
+
+        RenderGraph::destroyTargets(device, targets);
+        vkDestroyRenderPass(device.device(), renderPass, nullptr);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::exit(1);
+    }
+
+    return 0;
+}
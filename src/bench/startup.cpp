@@ -0,0 +1,193 @@
+#include "core/Device.hpp"
+#include "core/Model.hpp"
+#include "core/Pipeline.hpp"
+#include "core/PipelineBuilder.hpp"
+#include "core/Swapchain.hpp"
+#include "core/ShaderReflection.hpp"
+#include "core/Window.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Times every stage of engine startup separately over many repetitions and prints the results as JSON to stdout.
+ * Runs headless by default, so it works against software drivers such as lavapipe on machines without a display.
+ * Every repetition starts once without a pipeline cache and once with the cache the cold start left behind, both are
+ * reported separately. The cache lives in a temporary file, the application's own cache is never touched.
+ * The pipeline variant stages always time an empty cache.
+ */
+
+namespace
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    constexpr uint32_t WIDTH{ 800 };
+    constexpr uint32_t HEIGHT{ 600 };
+
+    struct Samples
+    {
+        std::map<std::string, std::vector<double>> stages;
+
+        void add(const std::string& stage, double ms) { stages[stage].push_back(ms); }
+    };
+
+    void runOnce(Samples& samples, bool windowed, const std::filesystem::path& cachePath)
+    {
+        std::unique_ptr<Window> window{ windowed ? std::make_unique<Window>(WIDTH, HEIGHT, "startup benchmark") : nullptr };
+
+        auto deviceStart{ std::chrono::steady_clock::now() };
+        Device device{ window.get(), cachePath };
+        samples.add("device", Milliseconds(std::chrono::steady_clock::now() - deviceStart).count());
+        samples.add("createInstance", device.startupTimings.createInstanceMs);
+        samples.add("pickPhysicalDevice", device.startupTimings.pickPhysicalDeviceMs);
+        samples.add("createLogicalDevice", device.startupTimings.createLogicalDeviceMs);
+
+        auto swapchainStart{ std::chrono::steady_clock::now() };
+        Swapchain swapchain{ device, window ? window->getExtent() : VkExtent2D{ WIDTH, HEIGHT } };
+        samples.add("swapchain", Milliseconds(std::chrono::steady_clock::now() - swapchainStart).count());
+
+        auto reflectionStart{ std::chrono::steady_clock::now() };
+        ShaderReflection reflection{ ShaderReflection::reflectFiles({ "shaders/simple.vert.spv", "shaders/simple.frag.spv" }) };
+        reflection.useDynamicOffsets(0, 0);
+        VkPipelineLayout pipelineLayout{ device.pipelineLayouts().get(reflection).handle };
+        samples.add("reflectLayout", Milliseconds(std::chrono::steady_clock::now() - reflectionStart).count());
+
+        auto pipelineConfig{ Pipeline::defaultPipelineConfigInfo() };
+        pipelineConfig.renderPass = swapchain.getRenderPass();
+        pipelineConfig.pipelineLayout = pipelineLayout;
+
+        VertexInputDescription vertexInput{ Model::vertexInputDescription(VertexLayout::Interleaved, reflection) };
+        pipelineConfig.bindingDescriptions = vertexInput.bindings;
+        pipelineConfig.attributeDescriptions = vertexInput.attributes;
+
+        {
+            Pipeline pipeline{ device, "shaders/simple.vert.spv", "shaders/simple.frag.spv", pipelineConfig };
+            samples.add("shaderModules", pipeline.timings().shaderModulesMs);
+            samples.add("createGraphicsPipelines", pipeline.timings().createPipelineMs);
+        }
+
+        // the variants below start from empty caches, so the warm run gets what the startup stages left behind
+        device.pipelineCache().save();
+
+        // every permutation from the same SPIR-V, only the specialization constants and fixed function state differ
+        // each one against a fresh cache, otherwise the variant matching the pipeline above times a cache hit
+        for(const auto& named: PipelineVariants::ALL)
+        {
+            device.pipelineCache().reset();
+
+            auto variantConfig{ Pipeline::variantPipelineConfigInfo(named.variant) };
+            variantConfig.renderPass = pipelineConfig.renderPass;
+            variantConfig.pipelineLayout = pipelineLayout;
+            variantConfig.bindingDescriptions = pipelineConfig.bindingDescriptions;
+            variantConfig.attributeDescriptions = pipelineConfig.attributeDescriptions;
+
+            Pipeline pipeline{ device, "shaders/simple.vert.spv", "shaders/simple.frag.spv", variantConfig };
+            samples.add("variant." + std::string(named.name), pipeline.timings().createPipelineMs);
+        }
+
+        // the same permutations again, batched and spread over the builder's workers, without the cache the loop above filled
+        {
+            device.pipelineCache().reset();
+            PipelineBuilder builder{ device };
+            std::vector<PipelineBuildRequest> requests;
+
+            for(const auto& named: PipelineVariants::ALL)
+            {
+                auto variantConfig{ Pipeline::variantPipelineConfigInfo(named.variant) };
+                variantConfig.renderPass = pipelineConfig.renderPass;
+                variantConfig.pipelineLayout = pipelineLayout;
+                variantConfig.bindingDescriptions = pipelineConfig.bindingDescriptions;
+                variantConfig.attributeDescriptions = pipelineConfig.attributeDescriptions;
+
+                requests.push_back(PipelineBuildRequest{ "shaders/simple.vert.spv", "shaders/simple.frag.spv", variantConfig });
+            }
+
+            auto builderStart{ std::chrono::steady_clock::now() };
+            for(auto& future: builder.build(std::move(requests)))
+                future.get();
+            samples.add("variantsBatched", Milliseconds(std::chrono::steady_clock::now() - builderStart).count());
+        }
+    }
+
+    void writeStages(const Samples& samples)
+    {
+        bool first{ true };
+        for(auto [stage, values]: samples.stages)
+        {
+            std::sort(values.begin(), values.end());
+            double avg{ std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size()) };
+
+            std::cout << (first ? "\n" : ",\n") << "    \"" << stage << "\": { \"min\": " << values.front() <<
+                ", \"median\": " << values[values.size() / 2] <<
+                ", \"avg\": " << avg <<
+                ", \"max\": " << values.back() << " }";
+            first = false;
+        }
+    }
+
+    void writeJson(const Samples& cold, const Samples& warm, uint32_t repetitions, bool windowed)
+    {
+        std::cout << "{\n  \"repetitions\": " << repetitions << ",\n  \"mode\": \"" << (windowed ? "windowed" : "headless") << "\",\n  \"cold\": {";
+        writeStages(cold);
+        std::cout << "\n  },\n  \"warm\": {";
+        writeStages(warm);
+        std::cout << "\n  }\n}" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t repetitions{ 20 };
+    bool windowed{ false };
+
+    for(int i{ 1 }; i < argc; ++i)
+    {
+        std::string_view arg{ argv[i] };
+
+        if(arg == "--windowed")
+            windowed = true;
+        else if(arg == "--repetitions" && i + 1 < argc)
+            repetitions = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--repetitions N] [--windowed]" << std::endl;
+            return 1;
+        }
+    }
+
+    try
+    {
+        std::filesystem::path cachePath{ std::filesystem::temp_directory_path() / "startup_bench_pipeline_cache.bin" };
+        Samples cold;
+        Samples warm;
+
+        for(uint32_t i{ 0 }; i < repetitions; ++i)
+        {
+            std::filesystem::remove(cachePath);
+            runOnce(cold, windowed, cachePath);
+            // the cold run's device wrote the cache back on destruction
+            runOnce(warm, windowed, cachePath);
+        }
+
+        std::filesystem::remove(cachePath);
+        writeJson(cold, warm, repetitions, windowed);
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::exit(1);
+    }
+
+    return 0;
+}
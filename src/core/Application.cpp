@@ -1,116 +1,735 @@
 #include "Application.hpp"
+#include "Uploader.hpp"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
 #include <stdexcept>
 #include <vulkan/vulkan_core.h>
+#include <glm/gtc/matrix_transform.hpp>
 
-Application::Application()
-    : m_window{ WIDTH, HEIGHT, "vulkan" }
-    , m_device{ m_window }
-    , m_swapchain{ m_device, m_window.getExtent() }
+namespace
 {
+    constexpr const char* SHADER_DIRECTORY{ "shaders" };
+    constexpr const char* SIMPLE_VERT{ "shaders/simple.vert.spv" };
+    constexpr const char* SIMPLE_FRAG{ "shaders/simple.frag.spv" };
+    constexpr const char* INDIRECT_VERT{ "shaders/indirect.vert.spv" };
+
+    // encloses the triangle's vertices, which are all within sqrt(0.5) of the origin
+    constexpr glm::vec4 TRIANGLE_BOUNDS{ 0.f, 0.f, 0.f, 0.7072f };
+}
+
+Application::Application(const ApplicationConfig& config)
+    : m_config{ config }
+    , m_window{ config.headless ? nullptr : std::make_unique<Window>(WIDTH, HEIGHT, "vulkan") }
+    , m_device{ m_window.get() }
+    , m_swapchain{ m_device, windowExtent(), config.presentPolicy }
+    , m_gpuTimer{ m_device, m_swapchain.framesInFlight() }
+    , m_uniformRing{ m_device, m_swapchain.framesInFlight(), sizeof(DrawData), MAX_DRAWS_PER_FRAME }
+    , m_pipelineBuilder{ m_device }
+    , m_pipelineRegistry{ m_pipelineBuilder }
+    , m_textures{ m_device, m_swapchain.framesInFlight() }
+{
+    loadModels();
+    createScene();
+    createIndirectRenderer();
     createPipelineLayout();
     createPipeline();
-    createCommandBuffers();
+    createFrameContexts();
+
+    for(const auto& path: m_config.texturePaths)
+        m_textures.load(path);
+
+    if(m_config.hotReload)
+    {
+        m_shaderWatcher = std::make_unique<ShaderWatcher>(SHADER_DIRECTORY);
+        m_shaderCompiler = std::make_unique<ShaderCompiler>();
+    }
 }
 
 Application::~Application()
 {
-    vkDestroyPipelineLayout(m_device.device(), m_pipelineLayout, nullptr);
+    // background builds use the render pass and the device's caches
+    m_pipelineRegistry.waitIdle();
+
+    for(auto& frame: m_frames)
+    {
+        vkDestroyCommandPool(m_device.device(), frame.commandPool, nullptr);
+
+        for(auto pool: frame.recorderPools)
+            vkDestroyCommandPool(m_device.device(), pool, nullptr);
+
+        vkDestroyCommandPool(m_device.device(), frame.computePool, nullptr);
+        vkDestroySemaphore(m_device.device(), frame.computeFinished, nullptr);
+    }
 }
 
 void Application::run()
 {
-    while(!m_window.shouldClose())
+    if(m_config.headless)
+        runHeadless();
+    else
     {
-        glfwPollEvents();
-        drawFrame();
+        while(!m_window->shouldClose())
+        {
+            glfwPollEvents();
+            drawFrame();
+        }
+
+        vkDeviceWaitIdle(m_device.device());
     }
 
+    writeFrameStats();
+}
+
+void Application::runHeadless()
+{
+    auto start{ std::chrono::steady_clock::now() };
+
+    for(uint32_t i{ 0 }; i < m_config.frameCount; ++i)
+        drawFrame();
+
     vkDeviceWaitIdle(m_device.device());
+
+    std::chrono::duration<double, std::milli> elapsed{ std::chrono::steady_clock::now() - start };
+    std::clog << "headless: rendered " << m_config.frameCount << " frames in " << elapsed.count() << " ms (" <<
+        m_config.frameCount / (elapsed.count() / 1000.0) << " fps)" << std::endl;
+}
+
+void Application::writeFrameStats()
+{
+    std::clog << "present policy: " << toString(m_swapchain.presentPolicy()) << ", " << m_swapchain.framesInFlight() << " frames in flight";
+    if(!m_config.headless)
+        std::clog << ", " << toString(m_swapchain.presentMode());
+    std::clog << std::endl;
+
+    std::clog << "pipeline registry: " << m_pipelineRegistry.size() << " pipelines, " << m_pipelineRegistry.hits() << " hits, " <<
+        m_pipelineRegistry.misses() << " misses" << std::endl;
+
+    m_frameStats.writeSummary(std::clog);
+    std::clog << std::endl;
+
+    if(m_config.statsPath.empty())
+        return;
+
+    std::ofstream file(m_config.statsPath);
+    if(!file.is_open())
+        throw std::runtime_error("Failure opening the file at: " + m_config.statsPath);
+
+    if(std::filesystem::path(m_config.statsPath).extension() == ".json")
+        m_frameStats.writeJson(file);
+    else
+        m_frameStats.writeCsv(file);
+}
+
+VkExtent2D Application::windowExtent()
+{
+    if(m_window)
+        return m_window->getExtent();
+
+    return { static_cast<uint32_t>(WIDTH), static_cast<uint32_t>(HEIGHT) };
+}
+
+void Application::recreateSwapchain()
+{
+    auto start{ std::chrono::steady_clock::now() };
+
+    // a minimized window has a zero sized framebuffer, nothing can be rendered until it is restored
+    VkExtent2D extent{ windowExtent() };
+    while((extent.width == 0 || extent.height == 0) && !m_window->shouldClose())
+    {
+        glfwWaitEvents();
+        extent = windowExtent();
+    }
+
+    if(extent.width == 0 || extent.height == 0)
+        return;
+
+    // a build in flight may use the old render pass, it has to finish before that can be retired
+    m_pipelineRegistry.waitIdle();
+
+    VkRenderPass oldRenderPass{ m_swapchain.getRenderPass() };
+    m_window->resetWindowResizedFlag();
+    m_swapchain.recreate(extent);
+
+    // viewport and scissor are dynamic, the pipelines only have to follow a render pass recreated for a new surface format
+    if(m_swapchain.getRenderPass() != oldRenderPass)
+    {
+        m_pipelineRegistry.evictRenderPass(oldRenderPass);
+        createFallbackPipeline();
+        replacePipeline(m_pipeline, nullptr);
+        replacePipeline(m_indirectPipeline, nullptr);
+        requestPipelines();
+    }
+
+    std::chrono::duration<double, std::milli> elapsed{ std::chrono::steady_clock::now() - start };
+    std::clog << "swapchain recreated at " << extent.width << "x" << extent.height << " in " << elapsed.count() << " ms" << std::endl;
+}
+
+void Application::retirePipeline(std::shared_ptr<Pipeline> pipeline)
+{
+    m_retiredPipelines.emplace_back(m_frameNumber, std::move(pipeline));
+}
+
+void Application::replacePipeline(std::shared_ptr<Pipeline>& current, std::shared_ptr<Pipeline> replacement)
+{
+    if(current && current != replacement)
+        retirePipeline(std::move(current));
+    current = std::move(replacement);
+}
+
+void Application::releaseRetiredPipelines()
+{
+    // called after the fence wait in acquireNextImage, once every frame slot has cycled the pipeline is unused
+    std::erase_if(m_retiredPipelines, [this](const auto& retired) {
+        return m_frameNumber >= retired.first + m_swapchain.framesInFlight();
+    });
 }
 
 void Application::createPipelineLayout()
 {
-    VkPipelineLayoutCreateInfo createInfo{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .setLayoutCount = 0,
-        .pSetLayouts = nullptr,
-        .pushConstantRangeCount = 0,
-        .pPushConstantRanges = nullptr
-    };
+    // set 0 is the per draw data, bound once per draw with a dynamic offset into the uniform ring
+    ShaderReflection reflection{ ShaderReflection::reflectFiles({ SIMPLE_VERT, SIMPLE_FRAG }) };
+    reflection.useDynamicOffsets(0, 0);
 
-    if(vkCreatePipelineLayout(m_device.device(), &createInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
-        throw std::runtime_error("Failure while creating pipeline layout");
+    // a shader interface change after startup needs a restart, hot reload keeps this layout
+    PipelineLayoutCache::Layout layout{ m_device.pipelineLayouts().get(reflection) };
+    if(layout.setLayouts.size() != 1 || layout.setLayouts[0] != UniformRing::setLayout(m_device) || layout.pushConstants.size != 0)
+        throw std::runtime_error("Failure while creating pipeline layout: the shaders don't match the uniform ring");
+
+    m_pipelineLayout = layout.handle;
 }
 
-void Application::createPipeline()
+PipelineConfigInfo Application::pipelineConfig(const char* vertFilepath, VkPipelineLayout pipelineLayout)
+{
+    return pipelineConfig(vertFilepath, pipelineLayout, m_config.variant);
+}
+
+PipelineConfigInfo Application::pipelineConfig(const char* vertFilepath, VkPipelineLayout pipelineLayout, const PipelineVariant& variant)
 {
-    auto pipelineConfig{ Pipeline::defaultPipelineConfigInfo(WIDTH, HEIGHT) };
+    auto pipelineConfig{ Pipeline::variantPipelineConfigInfo(variant) };
     pipelineConfig.renderPass = m_swapchain.getRenderPass();
-    pipelineConfig.pipelineLayout = m_pipelineLayout;
+    pipelineConfig.pipelineLayout = pipelineLayout;
+
+    // reflected on every request, so a reloaded vertex shader reading fewer or other attributes gets a matching input state
+    VertexInputDescription vertexInput{ Model::vertexInputDescription(m_model->layout(), ShaderReflection::reflectFiles({ vertFilepath })) };
+    pipelineConfig.bindingDescriptions = vertexInput.bindings;
+    pipelineConfig.attributeDescriptions = vertexInput.attributes;
+
+    return pipelineConfig;
+}
+
+void Application::createPipeline()
+{
+    createFallbackPipeline();
+    requestPipelines();
+}
+
+void Application::createFallbackPipeline()
+{
+    // the only pipeline waited for on this thread, the cheapest variant so the first frames don't wait on the others
+    auto fallback{ m_pipelineRegistry.acquire(PipelineBuildRequest{ SIMPLE_VERT, SIMPLE_FRAG, pipelineConfig(SIMPLE_VERT, m_pipelineLayout, PipelineVariants::Unlit) }) };
+    replacePipeline(m_fallbackPipeline, fallback.get());
+}
+
+void Application::requestPipelines()
+{
+    std::vector<PipelineBuildRequest> requests;
+    std::vector<std::shared_ptr<Pipeline>*> targets;
+
+    requests.push_back(PipelineBuildRequest{ SIMPLE_VERT, SIMPLE_FRAG, pipelineConfig(SIMPLE_VERT, m_pipelineLayout) });
+    targets.push_back(&m_pipeline);
+
+    if(m_indirectRenderer)
+    {
+        requests.push_back(PipelineBuildRequest{ INDIRECT_VERT, SIMPLE_FRAG, pipelineConfig(INDIRECT_VERT, m_indirectRenderer->graphicsPipelineLayout()) });
+        targets.push_back(&m_indirectPipeline);
+    }
+
+    // a newer request for a slot supersedes the older one
+    std::erase_if(m_pendingPipelines, [&targets](const PendingPipeline& pending) {
+        return std::find(targets.begin(), targets.end(), pending.target) != targets.end();
+    });
+
+    auto futures{ m_pipelineRegistry.acquire(std::move(requests)) };
+    for(size_t i{ 0 }; i < futures.size(); ++i)
+        m_pendingPipelines.push_back(PendingPipeline{ .future = std::move(futures[i]), .target = targets[i] });
+}
+
+void Application::pollPendingPipelines()
+{
+    std::erase_if(m_pendingPipelines, [this](PendingPipeline& pending) {
+        if(pending.future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return false;
+
+        try
+        {
+            replacePipeline(*pending.target, pending.future.get());
+        }
+        catch(const std::exception& e)
+        {
+            std::clog << "pipeline build failed, keeping the previous pipeline: " << e.what() << std::endl;
+        }
+
+        return true;
+    });
+}
+
+void Application::loadModels()
+{
+    std::vector<Model::Vertex> vertices{
+        { .position = {  0.0f, -0.5f, 0.0f }, .color = { 1.0f, 0.0f, 0.0f } },
+        { .position = {  0.5f,  0.5f, 0.0f }, .color = { 0.0f, 1.0f, 0.0f } },
+        { .position = { -0.5f,  0.5f, 0.0f }, .color = { 0.0f, 0.0f, 1.0f } }
+    };
+    std::vector<uint32_t> indices{ 0, 1, 2 };
+
+    m_model = std::make_unique<Model>(m_device, vertices, indices);
+
+    // drawing doesn't wait on the transfer queue, so the geometry has to be resident before the first frame
+    m_device.uploader().wait(m_model->uploadTicket());
+}
+
+void Application::createScene()
+{
+    uint32_t objectCount{ m_config.indirectObjectCount };
+    Renderable renderable{ .pipeline = &m_pipeline, .model = m_model.get() };
+    m_scene.reserve(objectCount + 1);
+
+    m_scene.create(Transform{}, TRIANGLE_BOUNDS, renderable);
+
+    if(objectCount == 0)
+        return;
+
+    // a grid somewhat larger than clip space, so the objects around the border get culled
+    uint32_t columns{ static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(objectCount)))) };
+    float spacing{ 3.f / static_cast<float>(columns) };
+
+    for(uint32_t i{ 0 }; i < objectCount; ++i)
+    {
+        glm::vec3 position{ -1.5f + spacing * (static_cast<float>(i % columns) + 0.5f), -1.5f + spacing * (static_cast<float>(i / columns) + 0.5f), 0.5f };
+        m_scene.create(Transform{ .position = position, .scale = glm::vec3{ spacing * 0.8f } }, TRIANGLE_BOUNDS, renderable);
+    }
+}
+
+void Application::createIndirectRenderer()
+{
+    if(m_config.indirectObjectCount == 0)
+        return;
+
+    if(!IndirectRenderer::isSupported(m_device))
+    {
+        std::clog << "GPU driven drawing is not supported on this device, the scene is drawn from the CPU";
+        if(m_scene.size() > MAX_DRAWS_PER_FRAME)
+            std::clog << " with at most " << MAX_DRAWS_PER_FRAME << " visible objects per frame";
+        std::clog << std::endl;
+        return;
+    }
+
+    // the whole scene goes through the GPU driven path, the scene writes it into the renderer's buffers every frame
+    m_indirectRenderer = std::make_unique<IndirectRenderer>(m_device, *m_model, m_swapchain.framesInFlight(), static_cast<uint32_t>(m_scene.size()), INDIRECT_VERT, SIMPLE_FRAG);
+
+    m_asyncCompute = m_config.asyncCompute && m_device.hasAsyncCompute();
+    if(m_config.asyncCompute && !m_asyncCompute)
+        std::clog << "no dedicated compute queue family, culling runs on the graphics queue" << std::endl;
+}
+
+void Application::updateScene(uint32_t frame)
+{
+    // the CPU path culls here and computes the matrices of the visible draws while recording
+    if(!drawsIndirect())
+    {
+        m_culler.cull(m_scene, CullView{ .frustum = Frustum::fromViewProjection(m_viewProjection), .maxDistance = m_config.cullDistance });
+        return;
+    }
+
+    m_scene.writeObjects(m_indirectRenderer->objects(frame), m_threadPool);
+    m_indirectRenderer->setObjectCount(frame, static_cast<uint32_t>(m_scene.size()));
+}
+
+size_t Application::directDrawCount() const
+{
+    if(drawsIndirect())
+        return 0;
+
+    return std::min<size_t>(m_culler.visible().size(), MAX_DRAWS_PER_FRAME);
+}
+
+void Application::createFrameContexts()
+{
+    QueueFamilyIndices queueFamilyIndices{ m_device.findPhysicalQueueFamilies() };
+    m_frames.resize(m_swapchain.framesInFlight());
+
+    for(auto& frame: m_frames)
+    {
+        // no RESET_COMMAND_BUFFER_BIT, the whole pool is reset at once when the frame comes around again
+        VkCommandPoolCreateInfo poolInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            .queueFamilyIndex = queueFamilyIndices.graphicsFamily.value()
+        };
 
-    m_pipeline = std::make_unique<Pipeline>(m_device, "shaders/simple.vert.spv", "shaders/simple.frag.spv", pipelineConfig);
+        if(vkCreateCommandPool(m_device.device(), &poolInfo, nullptr, &frame.commandPool) != VK_SUCCESS)
+            throw std::runtime_error("Failure while creating frame command pool");
+
+        VkCommandBufferAllocateInfo allocInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = frame.commandPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1
+        };
+
+        if(vkAllocateCommandBuffers(m_device.device(), &allocInfo, &frame.commandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("Failure while allocating command buffers");
+
+        uint32_t recorderCount{ m_threadPool.size() + 1 };
+        frame.recorderPools.resize(recorderCount);
+        frame.secondaryBuffers.resize(recorderCount);
+
+        for(uint32_t i{ 0 }; i < recorderCount; ++i)
+        {
+            if(vkCreateCommandPool(m_device.device(), &poolInfo, nullptr, &frame.recorderPools[i]) != VK_SUCCESS)
+                throw std::runtime_error("Failure while creating recorder command pool");
+
+            VkCommandBufferAllocateInfo secondaryAllocInfo{
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = frame.recorderPools[i],
+                .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                .commandBufferCount = 1
+            };
+
+            if(vkAllocateCommandBuffers(m_device.device(), &secondaryAllocInfo, &frame.secondaryBuffers[i]) != VK_SUCCESS)
+                throw std::runtime_error("Failure while allocating secondary command buffers");
+        }
+
+        if(m_asyncCompute)
+            createComputeContext(frame);
+    }
 }
 
-void Application::createCommandBuffers()
+void Application::createComputeContext(FrameContext& frame)
 {
-    m_commandBuffers.resize(m_swapchain.imageCount());
+    VkCommandPoolCreateInfo poolInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = m_device.findPhysicalQueueFamilies().computeFamily.value()
+    };
+
+    if(vkCreateCommandPool(m_device.device(), &poolInfo, nullptr, &frame.computePool) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating compute command pool");
 
     VkCommandBufferAllocateInfo allocInfo{
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .commandPool = m_device.getCommandPool(),
+        .commandPool = frame.computePool,
         .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = static_cast<uint32_t>(m_commandBuffers.size())
+        .commandBufferCount = 1
     };
 
-    if(vkAllocateCommandBuffers(m_device.device(), &allocInfo, m_commandBuffers.data()) != VK_SUCCESS)
-        throw std::runtime_error("Failure while allocating command buffers");
+    if(vkAllocateCommandBuffers(m_device.device(), &allocInfo, &frame.computeCommandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failure while allocating compute command buffer");
 
-    for(size_t i{ 0 }; i < m_commandBuffers.size(); ++i)
+    VkSemaphoreCreateInfo semaphoreInfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
+    };
+
+    if(vkCreateSemaphore(m_device.device(), &semaphoreInfo, nullptr, &frame.computeFinished) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating compute semaphore");
+}
+
+void Application::recordCommandBuffer(FrameContext& frame, uint32_t imageIndex)
+{
+    VkCommandBuffer commandBuffer{ frame.commandBuffer };
+
+    VkCommandBufferBeginInfo beginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    };
+
+    if(vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        throw std::runtime_error("Failure while begining to record command buffer");
+
+    uint32_t timerSlot{ static_cast<uint32_t>(m_swapchain.currentFrame()) };
+    m_gpuTimer.begin(commandBuffer, timerSlot);
+
+    if(m_indirectRenderer && !m_asyncCompute)
+        m_indirectRenderer->cull(commandBuffer, static_cast<uint32_t>(m_swapchain.currentFrame()), m_viewProjection);
+
+    const std::vector<VkClearValue>& clearValues{ m_swapchain.clearValues() };
+    VkRenderPassBeginInfo renderPassInfo{
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+        .renderPass = m_swapchain.getRenderPass(),
+        .framebuffer = m_swapchain.getFramebuffer(imageIndex),
+        .renderArea = VkRect2D{
+            .offset = { 0, 0 },
+            .extent = m_swapchain.getSwapchainExtent()
+        },
+        .clearValueCount = static_cast<uint32_t>(clearValues.size()),
+        .pClearValues = clearValues.data()
+    };
+
+    size_t drawCount{ directDrawCount() };
+    uint32_t recorderCount{ static_cast<uint32_t>(std::min<size_t>(frame.secondaryBuffers.size(), drawCount / MIN_DRAWS_PER_RECORDER)) };
+
+    if(recorderCount > 1)
     {
-        VkCommandBufferBeginInfo beginInfo{
-            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
-        };
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-        if(vkBeginCommandBuffer(m_commandBuffers[i], &beginInfo) != VK_SUCCESS)
-            throw std::runtime_error("Failure while begining to record command buffer");
-
-        std::array<VkClearValue, 2> clearValues{ VkClearValue{ .color = { 0.1f, 0.1f, 0.1f, 1.f } }, VkClearValue{ .depthStencil = { 1.f, 0} } };
-        VkRenderPassBeginInfo renderPassInfo{
-            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-            .renderPass = m_swapchain.getRenderPass(),
-            .framebuffer = m_swapchain.getFramebuffer(i),
-            .renderArea = VkRect2D{
-                .offset = { 0, 0 },
-                .extent = m_swapchain.getSwapchainExtent()
-            },
-            .clearValueCount = static_cast<uint32_t>(clearValues.size()),
-            .pClearValues = clearValues.data()
-        };
+        size_t chunkSize{ (drawCount + recorderCount - 1) / recorderCount };
+        m_threadPool.parallelFor(recorderCount, [&](uint32_t recorder) {
+            size_t first{ recorder * chunkSize };
+            recordSecondary(frame, recorder, imageIndex, first, std::min(chunkSize, drawCount - first));
+        });
+
+        vkCmdExecuteCommands(commandBuffer, recorderCount, frame.secondaryBuffers.data());
+    }
+    else
+    {
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        Pipeline::setViewport(commandBuffer, m_swapchain.getSwapchainExtent());
+        recordDraws(commandBuffer, 0, drawCount);
+        recordIndirectDraws(commandBuffer);
+    }
+
+    vkCmdEndRenderPass(commandBuffer);
+    m_gpuTimer.end(commandBuffer, timerSlot);
+
+    if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failure while recording command buffer");
+}
+
+void Application::recordSecondary(FrameContext& frame, uint32_t recorder, uint32_t imageIndex, size_t first, size_t count)
+{
+    VkCommandBuffer commandBuffer{ frame.secondaryBuffers[recorder] };
+    vkResetCommandPool(m_device.device(), frame.recorderPools[recorder], 0);
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass = m_swapchain.getRenderPass(),
+        .subpass = 0,
+        .framebuffer = m_swapchain.getFramebuffer(imageIndex)
+    };
+
+    VkCommandBufferBeginInfo beginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inheritanceInfo
+    };
+
+    if(vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        throw std::runtime_error("Failure while begining to record secondary command buffer");
 
-        vkCmdBeginRenderPass(m_commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    // dynamic state isn't inherited from the primary
+    Pipeline::setViewport(commandBuffer, m_swapchain.getSwapchainExtent());
+    recordDraws(commandBuffer, first, count);
+    // the primary can't record inline draws into a subpass that executes secondaries
+    if(recorder == 0)
+        recordIndirectDraws(commandBuffer);
 
-        m_pipeline->bind(m_commandBuffers[i]);
-        vkCmdDraw(m_commandBuffers[i], 3, 1, 0, 0);
+    if(vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failure while recording secondary command buffer");
+}
+
+void Application::recordDraws(VkCommandBuffer commandBuffer, size_t first, size_t count)
+{
+    Pipeline* boundPipeline{ nullptr };
+    Model* boundModel{ nullptr };
+    VkDescriptorSet drawSet{ m_uniformRing.descriptorSet() };
+    const std::vector<uint32_t>& visible{ m_culler.visible() };
+
+    for(size_t i{ first }; i < first + count; ++i)
+    {
+        uint32_t object{ visible[i] };
+        const Renderable& item{ m_scene.renderables()[object] };
+
+        // the fallback shares the layout, so the set stays valid across pipeline switches
+        uint32_t dynamicOffset{ m_uniformRing.push(DrawData{ .modelViewProjection = m_viewProjection * m_scene.worldMatrix(object) }) };
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &drawSet, 1, &dynamicOffset);
+        Pipeline* pipeline{ *item.pipeline ? item.pipeline->get() : m_fallbackPipeline.get() };
+
+        if(pipeline != boundPipeline)
+        {
+            pipeline->bind(commandBuffer);
+            boundPipeline = pipeline;
+        }
 
-        vkCmdEndRenderPass(m_commandBuffers[i]);
+        if(item.model != boundModel)
+        {
+            item.model->bind(commandBuffer);
+            boundModel = item.model;
+        }
 
-        if(vkEndCommandBuffer(m_commandBuffers[i]) != VK_SUCCESS)
-            throw std::runtime_error("Failure while recording command buffer");
+        item.model->draw(commandBuffer);
     }
 }
 
+void Application::recordIndirectDraws(VkCommandBuffer commandBuffer)
+{
+    // the fallback's layout doesn't fit the indirect shaders, recordDraws covers the scene until the pipeline is built
+    if(!drawsIndirect())
+        return;
+
+    m_indirectPipeline->bind(commandBuffer);
+    m_indirectRenderer->draw(commandBuffer, static_cast<uint32_t>(m_swapchain.currentFrame()));
+}
+
+void Application::submitCompute(FrameContext& frame)
+{
+    // the graphics submit of this frame waited on computeFinished, so the frame's fence covers the compute work too
+    vkResetCommandPool(m_device.device(), frame.computePool, 0);
+
+    VkCommandBufferBeginInfo beginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    };
+
+    if(vkBeginCommandBuffer(frame.computeCommandBuffer, &beginInfo) != VK_SUCCESS)
+        throw std::runtime_error("Failure while begining to record compute command buffer");
+
+    m_indirectRenderer->cull(frame.computeCommandBuffer, static_cast<uint32_t>(m_swapchain.currentFrame()), m_viewProjection);
+
+    if(vkEndCommandBuffer(frame.computeCommandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failure while recording compute command buffer");
+
+    VkSubmitInfo submitInfo{
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &frame.computeCommandBuffer,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores = &frame.computeFinished
+    };
+
+    if(vkQueueSubmit(m_device.computeQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        throw std::runtime_error("Failure while submitting compute command buffer");
+}
+
+void Application::pollShaderReload()
+{
+    for(auto& source: m_shaderWatcher->poll())
+        m_changedShaders.insert(source);
+
+    if(m_shaderReload.valid())
+    {
+        if(m_shaderReload.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return;
+
+        try
+        {
+            ShaderReload reload{ m_shaderReload.get() };
+            std::clog << "recompiled " << reload.sources.size() << " shader(s) in " << reload.compileMs << " ms" << std::endl;
+
+            // only pipelines whose SPIR-V changed miss the registry, the rest are handed back as they are
+            requestPipelines();
+        }
+        catch(const std::exception& e)
+        {
+            std::clog << "shader reload failed, keeping the previous pipelines: " << e.what() << std::endl;
+        }
+    }
+
+    if(!m_changedShaders.empty())
+        launchShaderReload();
+}
+
+void Application::launchShaderReload()
+{
+    std::vector<std::filesystem::path> sources(m_changedShaders.begin(), m_changedShaders.end());
+    m_changedShaders.clear();
+
+    m_shaderReload = std::async(std::launch::async, [this, sources]() {
+        auto start{ std::chrono::steady_clock::now() };
+        ShaderReload reload{ .sources = sources };
+
+        // the cull shader is compiled as well but only picked up on the next start
+        for(const auto& source: sources)
+            m_shaderCompiler->compile(source, source.string() + ".spv");
+
+        reload.compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return reload;
+    });
+}
+
 void Application::drawFrame()
 {
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    auto frameStart{ Clock::now() };
+
+    pollPendingPipelines();
+    if(m_shaderWatcher)
+        pollShaderReload();
+
+    // everything queued for upload since the last frame goes out in one submit, texture data included
+    m_textures.update();
+    m_device.uploader().flush();
+
     uint32_t imageIndex;
+    auto acquireStart{ Clock::now() };
     auto result{ m_swapchain.acquireNextImage(&imageIndex) };
+    auto acquireEnd{ Clock::now() };
+
+    if(result == VK_ERROR_OUT_OF_DATE_KHR)
+    {
+        recreateSwapchain();
+        return;
+    }
 
     if(result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
         throw std::runtime_error("Failure while acquireing swap chain image");
 
-    result = m_swapchain.submitCommandBuffers(&m_commandBuffers[imageIndex], &imageIndex);
+    releaseRetiredPipelines();
+
+    // acquireNextImage waited on this frame's fence, nothing recorded into its pool is in use anymore
+    FrameContext& frame{ m_frames[m_swapchain.currentFrame()] };
+    m_uniformRing.beginFrame(static_cast<uint32_t>(m_swapchain.currentFrame()));
+
+    auto sceneStart{ Clock::now() };
+    updateScene(static_cast<uint32_t>(m_swapchain.currentFrame()));
+    double sceneMs{ Milliseconds(Clock::now() - sceneStart).count() };
 
-    if(result != VK_SUCCESS)
+    if(auto gpuMs{ m_gpuTimer.read(static_cast<uint32_t>(m_swapchain.currentFrame())) })
+        m_frameStats.setGpuTime(frame.timedFrame, *gpuMs);
+    if(frame.gpuDonePending)
+        m_frameStats.setInputToGpuDone(frame.timedFrame, Milliseconds(m_swapchain.lastFenceSignaled() - frame.inputTime).count());
+
+    // events were polled right before drawFrame, so the frame start is when its input was sampled
+    frame.timedFrame = m_frameNumber;
+    frame.inputTime = frameStart;
+    frame.gpuDonePending = true;
+
+    VkSemaphore computeFinished{ VK_NULL_HANDLE };
+    if(m_asyncCompute)
+    {
+        submitCompute(frame);
+        computeFinished = frame.computeFinished;
+    }
+
+    vkResetCommandPool(m_device.device(), frame.commandPool, 0);
+    recordCommandBuffer(frame, imageIndex);
+    auto recordEnd{ Clock::now() };
+
+    result = m_swapchain.submitCommandBuffers(&frame.commandBuffer, &imageIndex, computeFinished, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+    auto submitEnd{ Clock::now() };
+
+    bool outOfDate{ result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || (m_window && m_window->wasWindowResized()) };
+    if(result != VK_SUCCESS && !outOfDate)
         throw std::runtime_error("failure while submitting command buffer");
+
+    double fenceWaitMs{ m_swapchain.lastFenceWaitMs() };
+    m_frameStats.push(FrameTiming{
+        .frame = m_frameNumber++,
+        .fenceWaitMs = fenceWaitMs,
+        .acquireMs = Milliseconds(acquireEnd - acquireStart).count() - fenceWaitMs,
+        .sceneMs = sceneMs,
+        .recordMs = Milliseconds(recordEnd - acquireEnd).count() - sceneMs,
+        .submitMs = Milliseconds(submitEnd - recordEnd).count(),
+        .cpuFrameMs = Milliseconds(submitEnd - frameStart).count()
+    });
+
+    if(outOfDate)
+        recreateSwapchain();
 }
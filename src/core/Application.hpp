@@ -7,17 +7,65 @@
 #include "Device.hpp"
 #include "Swapchain.hpp"
 #include "Pipeline.hpp"
+#include "Model.hpp"
+#include "IndirectRenderer.hpp"
+#include "Scene.hpp"
+#include "SceneCuller.hpp"
+#include "ThreadPool.hpp"
+#include "PipelineBuilder.hpp"
+#include "PipelineRegistry.hpp"
+#include "FrameStats.hpp"
+#include "GpuTimer.hpp"
+#include "UniformRing.hpp"
+#include "ShaderWatcher.hpp"
+#include "ShaderCompiler.hpp"
+#include "TextureStreamer.hpp"
 
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <limits>
 #include <memory>
+#include <set>
+#include <string>
+#include <utility>
 #include <vector>
 
+struct ApplicationConfig
+{
+    // render offscreen without a window, e.g. on CI machines that only have a software rasterizer
+    bool headless{ false };
+    // frames rendered in headless mode
+    uint32_t frameCount{ 1000 };
+    // frame timings are written here on exit, as JSON for a .json extension and as CSV otherwise
+    std::string statsPath;
+    PresentPolicy presentPolicy{ PresentPolicy::Balanced };
+    // permutation used by the scene pipelines, see PipelineVariants
+    PipelineVariant variant{ PipelineVariants::Opaque };
+    // instances of the model added to the scene and drawn through the GPU culled indirect path, 0 disables it
+    uint32_t indirectObjectCount{ 0 };
+    // cull on a dedicated compute queue so it overlaps the previous frame's rasterization, ignored without one
+    bool asyncCompute{ false };
+    // recompile edited shaders in the background and swap the affected pipelines in between frames
+    bool hotReload{ false };
+    // objects farther away are culled when the scene is drawn from the CPU, measured from the origin until there is a camera
+    float cullDistance{ std::numeric_limits<float>::infinity() };
+    // streamed in the background from startup on, nothing samples them yet, the log shows when each one became resident
+    std::vector<std::filesystem::path> texturePaths;
+};
+
 class Application
 {
 public:
     static constexpr int WIDTH{ 800 };
     static constexpr int HEIGHT{ 600 };
+    // below this many draws per recorder the cost of a secondary command buffer outweighs the parallelism
+    static constexpr uint32_t MIN_DRAWS_PER_RECORDER{ 256 };
+    // blocks in each frame's region of the uniform ring
+    static constexpr uint32_t MAX_DRAWS_PER_FRAME{ 4096 };
 
-    Application();
+    Application(const ApplicationConfig& config = {});
     ~Application();
 
     Application(const Application&) = delete;
@@ -26,18 +74,117 @@ public:
     void run();
 
 private:
-    Window m_window;
+    // everything a frame in flight records into, only touched again after the frame's fence signaled
+    struct FrameContext
+    {
+        VkCommandPool commandPool{ VK_NULL_HANDLE };
+        VkCommandBuffer commandBuffer{ VK_NULL_HANDLE };
+
+        // one pool per recorder, a pool is only ever used by the thread recording that slice of the draw list
+        std::vector<VkCommandPool> recorderPools;
+        std::vector<VkCommandBuffer> secondaryBuffers;
+
+        // async compute only, the graphics submit waits on computeFinished before reading the culled draws
+        VkCommandPool computePool{ VK_NULL_HANDLE };
+        VkCommandBuffer computeCommandBuffer{ VK_NULL_HANDLE };
+        VkSemaphore computeFinished{ VK_NULL_HANDLE };
+
+        // frame number whose timestamps were last written into this frame's GpuTimer slot
+        uint64_t timedFrame{ 0 };
+        // when the input for timedFrame was sampled, inputToGpuDoneMs is taken once the frame's fence is waited on again
+        std::chrono::steady_clock::time_point inputTime;
+        bool gpuDonePending{ false };
+    };
+
+    // shaders recompiled on a background thread, the pipelines are requested again once it is done
+    struct ShaderReload
+    {
+        std::vector<std::filesystem::path> sources;
+        double compileMs{ 0.0 };
+    };
+
+    // a pipeline requested from the registry, swapped into its slot once built
+    struct PendingPipeline
+    {
+        PipelineRegistry::PipelineFuture future;
+        std::shared_ptr<Pipeline>* target;
+    };
+
+    // per draw uniform block, matches DrawData in simple.vert
+    struct DrawData
+    {
+        glm::mat4 modelViewProjection;
+    };
+
+    ApplicationConfig m_config;
+    std::unique_ptr<Window> m_window;
     Device m_device;
     Swapchain m_swapchain;
-    std::unique_ptr<Pipeline> m_pipeline;
+    GpuTimer m_gpuTimer;
+    UniformRing m_uniformRing;
+    ThreadPool m_threadPool;
+    PipelineBuilder m_pipelineBuilder;
+    PipelineRegistry m_pipelineRegistry;
+    TextureStreamer m_textures;
+    std::shared_ptr<Pipeline> m_fallbackPipeline;
+    std::shared_ptr<Pipeline> m_pipeline;
+    std::unique_ptr<Model> m_model;
+    std::unique_ptr<IndirectRenderer> m_indirectRenderer;
+    std::shared_ptr<Pipeline> m_indirectPipeline;
+    bool m_asyncCompute{ false };
+    // no camera yet, clip space is world space
+    glm::mat4 m_viewProjection{ 1.f };
 
+    // owned by the device's layout cache
     VkPipelineLayout m_pipelineLayout;
-    std::vector<VkCommandBuffer> m_commandBuffers;
+    std::vector<FrameContext> m_frames;
+    Scene m_scene;
+    SceneCuller m_culler{ m_threadPool };
+
+    // pipelines replaced while older frames may still be executing with them, stamped with the frame they were retired at
+    std::vector<std::pair<uint64_t, std::shared_ptr<Pipeline>>> m_retiredPipelines;
+    std::vector<PendingPipeline> m_pendingPipelines;
+
+    std::unique_ptr<ShaderWatcher> m_shaderWatcher;
+    std::unique_ptr<ShaderCompiler> m_shaderCompiler;
+    std::set<std::filesystem::path> m_changedShaders;
+    std::future<ShaderReload> m_shaderReload;
+
+    FrameStats m_frameStats;
+    uint64_t m_frameNumber{ 0 };
 
     void createPipelineLayout();
+    PipelineConfigInfo pipelineConfig(const char* vertFilepath, VkPipelineLayout pipelineLayout);
+    PipelineConfigInfo pipelineConfig(const char* vertFilepath, VkPipelineLayout pipelineLayout, const PipelineVariant& variant);
     void createPipeline();
-    void createCommandBuffers();
+    void createFallbackPipeline();
+    void requestPipelines();
+    void pollPendingPipelines();
+    void loadModels();
+    void createScene();
+    void createIndirectRenderer();
+    void updateScene(uint32_t frame);
+    // the scene is drawn through the CPU path with the fallback until the indirect pipeline is built
+    bool drawsIndirect() const { return m_indirectRenderer && m_indirectPipeline; }
+    size_t directDrawCount() const;
+    void createFrameContexts();
+    void createComputeContext(FrameContext& frame);
+
+    void recordCommandBuffer(FrameContext& frame, uint32_t imageIndex);
+    void recordSecondary(FrameContext& frame, uint32_t recorder, uint32_t imageIndex, size_t first, size_t count);
+    void recordDraws(VkCommandBuffer commandBuffer, size_t first, size_t count);
+    void recordIndirectDraws(VkCommandBuffer commandBuffer);
+    void submitCompute(FrameContext& frame);
 
+    VkExtent2D windowExtent();
+    void recreateSwapchain();
+    void retirePipeline(std::shared_ptr<Pipeline> pipeline);
+    void replacePipeline(std::shared_ptr<Pipeline>& current, std::shared_ptr<Pipeline> replacement);
+    void releaseRetiredPipelines();
+    void runHeadless();
+    void writeFrameStats();
+    void pollShaderReload();
+    void launchShaderReload();
     void drawFrame();
 };
 
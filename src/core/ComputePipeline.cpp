@@ -0,0 +1,73 @@
+#include "ComputePipeline.hpp"
+#include "Pipeline.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+ComputePipeline::ComputePipeline(Device& device, const std::string& compFilepath, VkPipelineLayout pipelineLayout)
+    : device(device)
+{
+    assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipelineLayout provided");
+
+    std::vector<char> code{ Pipeline::readFile(compFilepath) };
+    VkShaderModuleCreateInfo moduleInfo{
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = code.size(),
+        .pCode = reinterpret_cast<const uint32_t*>(code.data())
+    };
+
+    if(vkCreateShaderModule(device.device(), &moduleInfo, nullptr, &m_shaderModule) != VK_SUCCESS)
+        throw std::runtime_error("Failure while Creating compute shader module");
+
+    VkComputePipelineCreateInfo pipelineInfo{
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = VkPipelineShaderStageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = m_shaderModule,
+            .pName = "main",
+            .pSpecializationInfo = nullptr
+        },
+        .layout = pipelineLayout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1
+    };
+
+    PipelineCache& pipelineCache{ device.pipelineCache() };
+    auto start{ std::chrono::steady_clock::now() };
+
+    if(vkCreateComputePipelines(device.device(), pipelineCache.handle(), 1, &pipelineInfo, nullptr, &m_computePipeline) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating compute pipeline");
+
+    pipelineCache.recordCreation(std::chrono::steady_clock::now() - start);
+}
+
+ComputePipeline::~ComputePipeline()
+{
+    vkDestroyShaderModule(device.device(), m_shaderModule, nullptr);
+    vkDestroyPipeline(device.device(), m_computePipeline, nullptr);
+}
+
+void ComputePipeline::bind(VkCommandBuffer commandBuffer)
+{
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_computePipeline);
+}
+
+void ComputePipeline::dispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+    vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+}
+
+void ComputePipeline::barrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    VkMemoryBarrier memoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = dstAccess
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dstStage, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+}
@@ -0,0 +1,33 @@
+#ifndef CORE_COMPUTE_PIPELINE_HPP
+#define CORE_COMPUTE_PIPELINE_HPP
+
+#include "Device.hpp"
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <string>
+
+class ComputePipeline
+{
+public:
+    ComputePipeline(Device& device, const std::string& compFilepath, VkPipelineLayout pipelineLayout);
+    ~ComputePipeline();
+
+    ComputePipeline(const ComputePipeline&) = delete;
+    void operator=(const ComputePipeline&) = delete;
+
+    void bind(VkCommandBuffer commandBuffer);
+    void dispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+
+    // makes the shader writes of earlier dispatches visible to later work on the same queue,
+    // consumers on another queue wait on a semaphore instead
+    static void barrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+private:
+    Device& device;
+    VkPipeline m_computePipeline;
+    VkShaderModule m_shaderModule;
+};
+
+#endif //!CORE_COMPUTE_PIPELINE_HPP
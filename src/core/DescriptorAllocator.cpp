@@ -0,0 +1,124 @@
+#include "DescriptorAllocator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+DescriptorAllocator::DescriptorAllocator(VkDevice device, DescriptorLayoutCache& layouts, uint32_t initialSetsPerPool)
+    : m_device(device), m_layouts(layouts), m_setsPerPool(std::max(initialSetsPerPool, 1u))
+{
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+    vkDestroyDescriptorPool(m_device, m_currentPool.handle, nullptr);
+
+    for(auto& pool: m_fullPools)
+        vkDestroyDescriptorPool(m_device, pool.handle, nullptr);
+    for(auto& pool: m_freePools)
+        vkDestroyDescriptorPool(m_device, pool.handle, nullptr);
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+{
+    // Vulkan 1.0 without VK_KHR_maintenance1 doesn't report an exhausted pool, allocating past the set
+    // or descriptor counts it was created with is invalid, so both are tracked here
+    const DescriptorCounts& counts{ m_layouts.descriptorCounts(layout) };
+    if(m_currentPool.handle == VK_NULL_HANDLE || !fits(m_currentPool, counts))
+    {
+        // whatever is left in the pool stays unused until the next reset
+        if(m_currentPool.handle != VK_NULL_HANDLE)
+            m_fullPools.push_back(m_currentPool);
+        m_currentPool = nextPool(counts);
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = m_currentPool.handle,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &layout
+    };
+
+    VkDescriptorSet set;
+    if(vkAllocateDescriptorSets(m_device, &allocInfo, &set) != VK_SUCCESS)
+        throw std::runtime_error("Failure while allocating descriptor set");
+
+    ++m_currentPool.allocated;
+    for(const auto& [type, count]: counts)
+        m_currentPool.available[type] -= count;
+
+    return set;
+}
+
+void DescriptorAllocator::reset()
+{
+    if(m_currentPool.handle != VK_NULL_HANDLE)
+        m_fullPools.push_back(m_currentPool);
+    m_currentPool = Pool{};
+
+    for(auto& pool: m_fullPools)
+    {
+        vkResetDescriptorPool(m_device, pool.handle, 0);
+        pool.allocated = 0;
+        pool.available = pool.size;
+        m_freePools.push_back(pool);
+    }
+
+    m_fullPools.clear();
+}
+
+bool DescriptorAllocator::fits(const Pool& pool, const DescriptorCounts& counts)
+{
+    if(pool.allocated == pool.capacity)
+        return false;
+
+    return std::all_of(counts.begin(), counts.end(), [&](const auto& entry) {
+        auto it{ pool.available.find(entry.first) };
+        return entry.second == 0 || (it != pool.available.end() && it->second >= entry.second);
+    });
+}
+
+DescriptorAllocator::Pool DescriptorAllocator::nextPool(const DescriptorCounts& counts)
+{
+    auto it{ std::find_if(m_freePools.begin(), m_freePools.end(), [&](const Pool& pool) { return fits(pool, counts); }) };
+    if(it != m_freePools.end())
+    {
+        Pool pool{ *it };
+        m_freePools.erase(it);
+        return pool;
+    }
+
+    Pool pool{ createPool(m_setsPerPool, counts) };
+    m_setsPerPool = std::min(m_setsPerPool * 2, MAX_SETS_PER_POOL);
+    return pool;
+}
+
+DescriptorAllocator::Pool DescriptorAllocator::createPool(uint32_t setCount, const DescriptorCounts& counts)
+{
+    DescriptorCounts size;
+    for(const auto& ratio: POOL_RATIOS)
+        size[ratio.type] = static_cast<uint32_t>(ratio.perSet * static_cast<float>(setCount));
+    // the set that asked for the pool always fits, also for types without a ratio
+    for(const auto& [type, count]: counts)
+        size[type] = std::max(size[type], count);
+
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for(const auto& [type, count]: size)
+    {
+        if(count > 0)
+            poolSizes.push_back(VkDescriptorPoolSize{ .type = type, .descriptorCount = count });
+    }
+
+    VkDescriptorPoolCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = 0,
+        .maxSets = setCount,
+        .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data()
+    };
+
+    Pool pool{ .capacity = setCount, .size = size, .available = size };
+    if(vkCreateDescriptorPool(m_device, &createInfo, nullptr, &pool.handle) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating descriptor pool");
+
+    return pool;
+}
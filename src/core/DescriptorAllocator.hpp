@@ -0,0 +1,80 @@
+#ifndef CORE_DESCRIPTOR_ALLOCATOR_HPP
+#define CORE_DESCRIPTOR_ALLOCATOR_HPP
+
+#include "DescriptorLayoutCache.hpp"
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Hands out descriptor sets from a growing list of pools, a full pool is left behind and the next one is twice as big.
+ * Sets are never freed one by one: a transient allocator is reset once per frame, which returns every pool at once,
+ * a long-lived allocator is never reset. Not thread safe, give every recording thread its own.
+ * Layouts have to come from the layout cache, their descriptor counts decide whether a set still fits a pool.
+ */
+class DescriptorAllocator
+{
+public:
+    static constexpr uint32_t INITIAL_SETS_PER_POOL{ 64 };
+    static constexpr uint32_t MAX_SETS_PER_POOL{ 4096 };
+
+    DescriptorAllocator(VkDevice device, DescriptorLayoutCache& layouts, uint32_t initialSetsPerPool = INITIAL_SETS_PER_POOL);
+    ~DescriptorAllocator();
+
+    DescriptorAllocator(const DescriptorAllocator&) = delete;
+    DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+    VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+    // every set allocated so far becomes invalid, only call once the GPU is done with them
+    void reset();
+
+    uint32_t poolCount() const { return static_cast<uint32_t>(m_fullPools.size() + m_freePools.size()) + (m_currentPool.handle != VK_NULL_HANDLE ? 1 : 0); }
+
+private:
+    struct Pool
+    {
+        VkDescriptorPool handle{ VK_NULL_HANDLE };
+        uint32_t capacity{ 0 };
+        uint32_t allocated{ 0 };
+        DescriptorCounts size;
+        DescriptorCounts available;
+    };
+
+    // descriptors per set of each type a pool is sized for, a set needing more than that gets a pool sized for it
+    struct PoolRatio
+    {
+        VkDescriptorType type;
+        float perSet;
+    };
+
+    static constexpr PoolRatio POOL_RATIOS[]{
+        { VK_DESCRIPTOR_TYPE_SAMPLER, 1.f },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.f },
+        { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 2.f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.f },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, .5f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, .5f },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3.f },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.f },
+        { VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1.f }
+    };
+
+    VkDevice m_device;
+    DescriptorLayoutCache& m_layouts;
+    uint32_t m_setsPerPool;
+    Pool m_currentPool;
+    std::vector<Pool> m_fullPools;
+    // reset pools waiting to be reused before a new one is created
+    std::vector<Pool> m_freePools;
+
+    static bool fits(const Pool& pool, const DescriptorCounts& counts);
+
+    Pool nextPool(const DescriptorCounts& counts);
+    Pool createPool(uint32_t setCount, const DescriptorCounts& counts);
+};
+
+#endif //!CORE_DESCRIPTOR_ALLOCATOR_HPP
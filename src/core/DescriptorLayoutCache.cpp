@@ -0,0 +1,63 @@
+#include "DescriptorLayoutCache.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+DescriptorLayoutCache::DescriptorLayoutCache(VkDevice device)
+    : m_device(device)
+{
+}
+
+DescriptorLayoutCache::~DescriptorLayoutCache()
+{
+    for(auto& [key, layout]: m_layouts)
+        vkDestroyDescriptorSetLayout(m_device, layout, nullptr);
+}
+
+VkDescriptorSetLayout DescriptorLayoutCache::get(std::vector<VkDescriptorSetLayoutBinding> bindings)
+{
+    std::sort(bindings.begin(), bindings.end(), [](const auto& a, const auto& b) { return a.binding < b.binding; });
+
+    std::vector<BindingKey> key;
+    key.reserve(bindings.size());
+    for(const auto& binding: bindings)
+    {
+        assert(binding.pImmutableSamplers == nullptr && "Immutable samplers are not supported by the descriptor layout cache");
+        key.emplace_back(binding.binding, binding.descriptorType, binding.descriptorCount, binding.stageFlags);
+    }
+
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    auto it{ m_layouts.find(key) };
+    if(it != m_layouts.end())
+        return it->second;
+
+    VkDescriptorSetLayoutCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data()
+    };
+
+    VkDescriptorSetLayout layout;
+    if(vkCreateDescriptorSetLayout(m_device, &createInfo, nullptr, &layout) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating descriptor set layout");
+
+    DescriptorCounts& counts{ m_counts[layout] };
+    for(const auto& binding: bindings)
+        counts[binding.descriptorType] += binding.descriptorCount;
+
+    m_layouts.emplace(std::move(key), layout);
+    return layout;
+}
+
+const DescriptorCounts& DescriptorLayoutCache::descriptorCounts(VkDescriptorSetLayout layout)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    auto it{ m_counts.find(layout) };
+    if(it == m_counts.end())
+        throw std::runtime_error("Failure while looking up descriptor counts: layout was not created by the cache");
+
+    return it->second;
+}
@@ -0,0 +1,47 @@
+#ifndef CORE_DESCRIPTOR_LAYOUT_CACHE_HPP
+#define CORE_DESCRIPTOR_LAYOUT_CACHE_HPP
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+// descriptors of each type a set of a layout takes from its pool
+using DescriptorCounts = std::map<VkDescriptorType, uint32_t>;
+
+/*
+ * Owns every VkDescriptorSetLayout, keyed by its binding signature, so identical layouts requested by different
+ * users are the same handle and sets allocated for one fit pipelines created with the other.
+ * Immutable samplers are not part of the signature and not supported.
+ */
+class DescriptorLayoutCache
+{
+public:
+    explicit DescriptorLayoutCache(VkDevice device);
+    ~DescriptorLayoutCache();
+
+    DescriptorLayoutCache(const DescriptorLayoutCache&) = delete;
+    DescriptorLayoutCache& operator=(const DescriptorLayoutCache&) = delete;
+
+    // the order of the bindings doesn't matter, the returned layout lives as long as the cache
+    VkDescriptorSetLayout get(std::vector<VkDescriptorSetLayoutBinding> bindings);
+
+    // only for layouts returned by get()
+    const DescriptorCounts& descriptorCounts(VkDescriptorSetLayout layout);
+
+    size_t size() const { return m_layouts.size(); }
+
+private:
+    // binding, type, count, stages
+    using BindingKey = std::tuple<uint32_t, VkDescriptorType, uint32_t, VkShaderStageFlags>;
+
+    VkDevice m_device;
+    std::map<std::vector<BindingKey>, VkDescriptorSetLayout> m_layouts;
+    std::map<VkDescriptorSetLayout, DescriptorCounts> m_counts;
+    std::mutex m_mutex;
+};
+
+#endif //!CORE_DESCRIPTOR_LAYOUT_CACHE_HPP
@@ -1,10 +1,14 @@
 #include "Device.hpp"
+#include "Uploader.hpp"
 
 #include <GLFW/glfw3.h>
+#include <chrono>
 #include <cstring>
 #include <set>
 #include <stdexcept>
+#include <string_view>
 #include <unordered_set>
+#include <utility>
 #include <vulkan/vulkan_core.h>
 
 #include <iostream>
@@ -45,25 +49,55 @@ void DestroyDebugUtilsMessengerEXT(
         func(instance, debugMessenger, pAllocator);
 }
 
-Device::Device(Window& window) : m_window(window)
+template<typename F>
+static double measureMs(F&& stage)
 {
-    createInstance();
+    auto start{ std::chrono::steady_clock::now() };
+    stage();
+
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+Device::Device(Window* window, std::filesystem::path pipelineCachePath) : m_window(window), m_pipelineCachePath(std::move(pipelineCachePath))
+{
+    auto start{ std::chrono::steady_clock::now() };
+
+    if(!isHeadless())
+        deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+    startupTimings.createInstanceMs = measureMs([this]() { createInstance(); });
     setupDebugMessenger();
     createSurface();
-    pickPhysicalDevice();
-    createLogicalDevice();
+    startupTimings.pickPhysicalDeviceMs = measureMs([this]() { pickPhysicalDevice(); });
+    startupTimings.createLogicalDeviceMs = measureMs([this]() { createLogicalDevice(); });
+    createAllocator();
+    createPipelineCache();
+    createDescriptors();
     createCommandPool();
+    createUploader();
+
+    startupTimings.totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
 Device::~Device()
 {
+    m_uploader.reset();
+    m_pipelineCache.reset();
+    m_descriptorAllocator.reset();
+    m_pipelineLayouts.reset();
+    m_descriptorLayouts.reset();
     vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+
+    std::clog << m_allocator->stats() << std::endl;
+    m_allocator.reset();
+
     vkDestroyDevice(m_device, nullptr);
 
     if(enableValidationLayers)
         DestroyDebugUtilsMessengerEXT(m_instance, m_debugMessenger, nullptr);
 
-    vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+    if(m_surface != VK_NULL_HANDLE)
+        vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
     vkDestroyInstance(m_instance, nullptr);
 }
 
@@ -145,7 +179,7 @@ void Device::createLogicalDevice()
     QueueFamilyIndices indices{ findQueueFamilies(m_physicalDevice) };
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    std::set<uint32_t> uniqueQueueFamilies{ indices.graphicsFamily.value_or(0), indices.presentFamily.value_or(0) };
+    std::set<uint32_t> uniqueQueueFamilies{ indices.graphicsFamily.value_or(0), indices.presentFamily.value_or(0), indices.transferFamily.value_or(0), indices.computeFamily.value_or(0) };
 
     float queuePriority{ 1.f };
     for(uint32_t queueFamily: uniqueQueueFamilies)
@@ -160,17 +194,27 @@ void Device::createLogicalDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
-    VkPhysicalDeviceFeatures deviceFeatures{
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(m_physicalDevice, &supportedFeatures);
+
+    // used by the GPU driven draw path, which falls back when they are missing
+    enabledFeatures = VkPhysicalDeviceFeatures{
+        .multiDrawIndirect = supportedFeatures.multiDrawIndirect,
+        .drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance,
         .samplerAnisotropy = VK_TRUE
     };
 
+    bool drawIndirectCount{ isDeviceExtensionAvailable(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) };
+    if(drawIndirectCount)
+        deviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
     VkDeviceCreateInfo createInfo{
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
         .queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
         .pQueueCreateInfos = queueCreateInfos.data(),
         .enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size()),
         .ppEnabledExtensionNames = deviceExtensions.data(),
-        .pEnabledFeatures = &deviceFeatures
+        .pEnabledFeatures = &enabledFeatures
     };
 
     if(enableValidationLayers)
@@ -189,6 +233,38 @@ void Device::createLogicalDevice()
 
     vkGetDeviceQueue(m_device, indices.graphicsFamily.value(), 0, &m_graphicsQueue);
     vkGetDeviceQueue(m_device, indices.presentFamily.value(), 0, &m_presentQueue);
+    vkGetDeviceQueue(m_device, indices.transferFamily.value(), 0, &m_transferQueue);
+    vkGetDeviceQueue(m_device, indices.computeFamily.value(), 0, &m_computeQueue);
+    m_asyncCompute = indices.computeFamily.value() != indices.graphicsFamily.value();
+
+    if(drawIndirectCount)
+        m_cmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(m_device, "vkCmdDrawIndexedIndirectCountKHR"));
+
+    // with concurrent sharing the async compute queue reads and writes buffers without ownership transfers
+    std::set<uint32_t> resourceFamilies{ indices.graphicsFamily.value(), indices.transferFamily.value(), indices.computeFamily.value() };
+    m_resourceQueueFamilies.assign(resourceFamilies.begin(), resourceFamilies.end());
+
+    if(indices.transferFamily.value() != indices.graphicsFamily.value())
+        std::clog << "Using dedicated transfer queue family " << indices.transferFamily.value() << std::endl;
+    if(m_asyncCompute)
+        std::clog << "Using async compute queue family " << indices.computeFamily.value() << std::endl;
+}
+
+void Device::createAllocator()
+{
+    m_allocator = std::make_unique<MemoryAllocator>(m_physicalDevice, m_device);
+}
+
+void Device::createPipelineCache()
+{
+    m_pipelineCache = std::make_unique<PipelineCache>(m_device, properties, m_pipelineCachePath);
+}
+
+void Device::createDescriptors()
+{
+    m_descriptorLayouts = std::make_unique<DescriptorLayoutCache>(m_device);
+    m_descriptorAllocator = std::make_unique<DescriptorAllocator>(m_device, *m_descriptorLayouts);
+    m_pipelineLayouts = std::make_unique<PipelineLayoutCache>(m_device, *m_descriptorLayouts);
 }
 
 void Device::createCommandPool()
@@ -205,9 +281,17 @@ void Device::createCommandPool()
         throw std::runtime_error("Failure while creating command pool");
 }
 
+void Device::createUploader()
+{
+    m_uploader = std::make_unique<Uploader>(*this);
+}
+
 void Device::createSurface()
 {
-    m_window.createWindowSurface(m_instance, &m_surface);
+    if(isHeadless())
+        return;
+
+    m_window->createWindowSurface(m_instance, &m_surface);
 }
 
 bool Device::isDeviceSuitable(VkPhysicalDevice device)
@@ -215,9 +299,9 @@ bool Device::isDeviceSuitable(VkPhysicalDevice device)
     QueueFamilyIndices indices{ findQueueFamilies(device) };
 
     bool extensionsSupported{ checkDeviceExtensionSupport(device) };
-    bool swapChainSuitable{ false };
+    bool swapChainSuitable{ isHeadless() };
 
-    if(extensionsSupported)
+    if(extensionsSupported && !isHeadless())
     {
         SwapchainSupportDetails swapChainSupport{ querySwapChainSupport(device) };
         swapChainSuitable = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -282,10 +366,15 @@ bool Device::checkValidationLayerSupport()
 
 std::vector<const char*> Device::getRequiredExtensions()
 {
-    uint32_t glfwExtensionCount{ 0 };
-    const char** glfwExtensions{ glfwGetRequiredInstanceExtensions(&glfwExtensionCount) };
+    std::vector<const char*> extensions;
 
-    std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    if(!isHeadless())
+    {
+        uint32_t glfwExtensionCount{ 0 };
+        const char** glfwExtensions{ glfwGetRequiredInstanceExtensions(&glfwExtensionCount) };
+
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if(enableValidationLayers)
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -336,6 +425,28 @@ bool Device::checkDeviceExtensionSupport(VkPhysicalDevice device)
     return requiredExtensions.empty();
 }
 
+bool Device::isDeviceExtensionAvailable(const char* extensionName)
+{
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+    for(const auto& extension: availableExtensions)
+    {
+        if(std::string_view(extension.extensionName) == extensionName)
+            return true;
+    }
+
+    return false;
+}
+
+void Device::cmdDrawIndexedIndirectCount(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount, uint32_t stride)
+{
+    m_cmdDrawIndexedIndirectCount(commandBuffer, buffer, offset, countBuffer, countOffset, maxDrawCount, stride);
+}
+
 QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device)
 {
     QueueFamilyIndices indices;
@@ -346,23 +457,36 @@ QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device)
     std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
+    std::optional<uint32_t> transferOnlyFamily;
+    std::optional<uint32_t> computeOnlyFamily;
     int i{ 0 };
     for(const auto& queueFamily: queueFamilies)
     {
-        if(queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        if(queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT && !indices.graphicsFamily.has_value())
             indices.graphicsFamily.emplace(i);
 
-        VkBool32 presentSupport{ false };
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_surface, &presentSupport);
-        if(queueFamily.queueCount > 0 && presentSupport)
+        // headless devices never present, the graphics queue stands in for the present queue
+        VkBool32 presentSupport{ isHeadless() && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT };
+        if(!isHeadless())
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_surface, &presentSupport);
+        if(queueFamily.queueCount > 0 && presentSupport && !indices.presentFamily.has_value())
             indices.presentFamily.emplace(i);
 
-        if(indices.isComplete())
-            break;
+        // a family without graphics and compute is usually backed by the DMA engines
+        constexpr VkQueueFlags otherWork{ VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT };
+        if(queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT && !(queueFamily.queueFlags & otherWork) && !transferOnlyFamily.has_value())
+            transferOnlyFamily.emplace(i);
+
+        if(queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT && !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && !computeOnlyFamily.has_value())
+            computeOnlyFamily.emplace(i);
 
         ++i;
     }
 
+    indices.transferFamily = transferOnlyFamily.has_value() ? transferOnlyFamily : indices.graphicsFamily;
+    // a graphics family always supports compute as well
+    indices.computeFamily = computeOnlyFamily.has_value() ? computeOnlyFamily : indices.graphicsFamily;
+
     return indices;
 }
 
@@ -408,6 +532,17 @@ VkFormat Device::findSupportedFormat(const std::vector<VkFormat>& candidates, Vk
     throw std::runtime_error("Failed to find supported format");
 }
 
+uint32_t Device::graphicsTimestampValidBits()
+{
+    uint32_t queueFamilyCount{ 0 };
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    return queueFamilies.at(findPhysicalQueueFamilies().graphicsFamily.value()).timestampValidBits;
+}
+
 uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
 {
     VkPhysicalDeviceMemoryProperties memProperties;
@@ -422,7 +557,7 @@ uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags prope
     throw std::runtime_error("Failed to find suitable memory type");
 }
 
-void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& bufferMemory)
 {
     VkBufferCreateInfo createInfo{
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
@@ -431,22 +566,29 @@ void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryP
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE
     };
 
+    if(m_resourceQueueFamilies.size() > 1)
+    {
+        createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        createInfo.queueFamilyIndexCount = static_cast<uint32_t>(m_resourceQueueFamilies.size());
+        createInfo.pQueueFamilyIndices = m_resourceQueueFamilies.data();
+    }
+
     if(vkCreateBuffer(m_device, &createInfo, nullptr, &buffer) != VK_SUCCESS)
         throw std::runtime_error("Failure while creating vertex buffer");
     
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(m_device, buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = memRequirements.size,
-        .memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties)
-    };
+    bufferMemory = m_allocator->allocate(memRequirements, properties, ResourceTiling::Linear);
 
-    if(vkAllocateMemory(m_device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
-        throw std::runtime_error("Failure while allocating vertex buffer memory");
+    if(vkBindBufferMemory(m_device, buffer, bufferMemory.memory, bufferMemory.offset) != VK_SUCCESS)
+        throw std::runtime_error("Failure while binding buffer memory");
+}
 
-    vkBindBufferMemory(m_device, buffer, bufferMemory, 0);
+void Device::destroyBuffer(VkBuffer buffer, MemoryAllocation& bufferMemory)
+{
+    vkDestroyBuffer(m_device, buffer, nullptr);
+    m_allocator->free(bufferMemory);
 }
 
 VkCommandBuffer Device::beginSingleTimeCommand()
@@ -481,31 +623,29 @@ void Device::endSingleTimeCommands(VkCommandBuffer commandBuffer)
         .pCommandBuffers = &commandBuffer
     };
 
-    vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(m_graphicsQueue);
+    VkFenceCreateInfo fenceInfo{
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+    };
+
+    // wait for this submission only instead of draining the whole graphics queue
+    VkFence fence;
+    if(vkCreateFence(m_device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating single time command fence");
+
+    vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, fence);
+    vkWaitForFences(m_device, 1, &fence, VK_TRUE, UINT64_MAX);
 
+    vkDestroyFence(m_device, fence, nullptr);
     vkFreeCommandBuffers(m_device, m_commandPool, 1, &commandBuffer);
 }
 
-void Device::copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size)
+UploadTicket Device::copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size)
 {
-    VkCommandBuffer commandBuffer{ beginSingleTimeCommand() };
-
-    VkBufferCopy copyRegion{
-        .srcOffset = 0,
-        .dstOffset = 0,
-        .size = size
-    };
-
-    vkCmdCopyBuffer(commandBuffer, src, dst, 1, &copyRegion);
-
-    endSingleTimeCommands(commandBuffer);
+    return m_uploader->copyBuffer(src, dst, size);
 }
 
-void Device::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount)
+UploadTicket Device::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount)
 {
-    VkCommandBuffer commandBuffer{ beginSingleTimeCommand() };
-
     VkBufferImageCopy region{
         .bufferOffset = 0,
         .bufferRowLength = 0,
@@ -517,16 +657,13 @@ void Device::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, u
             .layerCount = layerCount
         },
         .imageOffset = { 0, 0, 0 },
-        .imageExtent = { width, height, 0 }
+        .imageExtent = { width, height, 1 }
     };
 
-
-    vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-    endSingleTimeCommands(commandBuffer);
+    return m_uploader->copyBufferToImage(buffer, image, region);
 }
 
-void Device::createImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+void Device::createImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory)
 {
     if(vkCreateImage(m_device, &imageInfo, nullptr, &image) != VK_SUCCESS)
         throw std::runtime_error("Failure while creating an image");
@@ -534,15 +671,15 @@ void Device::createImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPro
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(m_device, image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = memRequirements.size,
-        .memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties)
-    };
+    ResourceTiling tiling{ imageInfo.tiling == VK_IMAGE_TILING_LINEAR ? ResourceTiling::Linear : ResourceTiling::Optimal };
+    imageMemory = m_allocator->allocate(memRequirements, properties, tiling);
 
-    if(vkAllocateMemory(m_device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-        throw std::runtime_error("Failure while allocating image memory");
-
-    if(vkBindImageMemory(m_device, image, imageMemory, 0) != VK_SUCCESS)
+    if(vkBindImageMemory(m_device, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS)
         throw std::runtime_error("Failure while binding image memory");
 }
+
+void Device::destroyImage(VkImage image, MemoryAllocation& imageMemory)
+{
+    vkDestroyImage(m_device, image, nullptr);
+    m_allocator->free(imageMemory);
+}
@@ -4,8 +4,15 @@
 #include <vulkan/vulkan_core.h>
 
 #include "Window.hpp"
+#include "MemoryAllocator.hpp"
+#include "PipelineCache.hpp"
+#include "DescriptorLayoutCache.hpp"
+#include "DescriptorAllocator.hpp"
+#include "PipelineLayoutCache.hpp"
 
 #include <cstdint>
+#include <filesystem>
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -16,14 +23,29 @@ struct SwapchainSupportDetails
     std::vector<VkPresentModeKHR> presentModes;
 };
 
+using UploadTicket = uint64_t;
+class Uploader;
+
 struct QueueFamilyIndices
 {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    std::optional<uint32_t> transferFamily;
+    // a compute family without graphics when there is one, so compute work can overlap rasterization
+    std::optional<uint32_t> computeFamily;
 
     bool isComplete() { return graphicsFamily.has_value() && presentFamily.has_value(); }
 };
 
+// wall clock time of the construction stages, kept around for the startup benchmark
+struct DeviceStartupTimings
+{
+    double createInstanceMs{ 0.0 };
+    double pickPhysicalDeviceMs{ 0.0 };
+    double createLogicalDeviceMs{ 0.0 };
+    double totalMs{ 0.0 };
+};
+
 class Device
 {
 public:
@@ -33,7 +55,11 @@ public:
         static constexpr bool enableValidationLayers{ false };
     #endif
 
-    Device(Window& window);
+    static constexpr const char* PIPELINE_CACHE_PATH{ "pipeline_cache.bin" };
+
+    // without a window the device is headless: no surface, no swapchain extension and no present support required
+    // an empty pipelineCachePath keeps the pipeline cache in memory only
+    explicit Device(Window* window, std::filesystem::path pipelineCachePath = PIPELINE_CACHE_PATH);
     ~Device();
 
     Device(const Device&) = delete;
@@ -44,42 +70,86 @@ public:
     VkCommandPool getCommandPool() { return m_commandPool; }
     VkDevice device() { return m_device; }
     VkSurfaceKHR surface() { return m_surface; }
+    bool isHeadless() const { return m_window == nullptr; }
     VkQueue graphicsQueue() { return m_graphicsQueue; }
     VkQueue presentQueue() { return m_presentQueue; }
+    VkQueue transferQueue() { return m_transferQueue; }
+    VkQueue computeQueue() { return m_computeQueue; }
+    // the compute queue belongs to a different family than the graphics queue
+    bool hasAsyncCompute() const { return m_asyncCompute; }
+    Uploader& uploader() { return *m_uploader; }
+    PipelineCache& pipelineCache() { return *m_pipelineCache; }
+    DescriptorLayoutCache& descriptorLayouts() { return *m_descriptorLayouts; }
+    // for sets kept until shutdown, they are never freed, transient sets need their own allocator reset every frame
+    DescriptorAllocator& descriptorAllocator() { return *m_descriptorAllocator; }
+    PipelineLayoutCache& pipelineLayouts() { return *m_pipelineLayouts; }
+    // queue families that touch buffers and images, resources shared between them use VK_SHARING_MODE_CONCURRENT
+    const std::vector<uint32_t>& resourceQueueFamilies() { return m_resourceQueueFamilies; }
 
     SwapchainSupportDetails getSwapchainSupport() { return querySwapChainSupport(m_physicalDevice); }
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
     QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(m_physicalDevice); }
     VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
+    uint32_t graphicsTimestampValidBits();
 
-    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, MemoryAllocation& bufferMemory);
+    void destroyBuffer(VkBuffer buffer, MemoryAllocation& bufferMemory);
     VkCommandBuffer beginSingleTimeCommand();
     void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-    void copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size);
-    void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
+    UploadTicket copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size);
+    UploadTicket copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
-    void createImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+    void createImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, MemoryAllocation& imageMemory);
+    void destroyImage(VkImage image, MemoryAllocation& imageMemory);
+
+    MemoryAllocator& allocator() { return *m_allocator; }
+    MemoryStats memoryStats() { return m_allocator->stats(); }
+
+    // VK_KHR_draw_indirect_count is optional, callers check support before recording the count variant
+    bool supportsDrawIndirectCount() const { return m_cmdDrawIndexedIndirectCount != nullptr; }
+    void cmdDrawIndexedIndirectCount(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount, uint32_t stride);
 
     VkPhysicalDeviceProperties properties;
+    // optional features are only enabled when the physical device supports them
+    VkPhysicalDeviceFeatures enabledFeatures{};
+    DeviceStartupTimings startupTimings;
 
 private:
     VkInstance m_instance;
     VkDebugUtilsMessengerEXT m_debugMessenger;
-    VkPhysicalDevice m_physicalDevice;
-    Window& m_window;
+    VkPhysicalDevice m_physicalDevice{ VK_NULL_HANDLE };
+    Window* m_window;
+    std::filesystem::path m_pipelineCachePath;
     VkCommandPool m_commandPool;
 
     VkDevice m_device;
-    VkSurfaceKHR m_surface;
+    VkSurfaceKHR m_surface{ VK_NULL_HANDLE };
     VkQueue m_graphicsQueue;
     VkQueue m_presentQueue;
+    VkQueue m_transferQueue;
+    VkQueue m_computeQueue;
+    bool m_asyncCompute{ false };
+    std::vector<uint32_t> m_resourceQueueFamilies;
+
+    std::unique_ptr<MemoryAllocator> m_allocator;
+    std::unique_ptr<Uploader> m_uploader;
+    std::unique_ptr<PipelineCache> m_pipelineCache;
+    std::unique_ptr<DescriptorLayoutCache> m_descriptorLayouts;
+    std::unique_ptr<DescriptorAllocator> m_descriptorAllocator;
+    std::unique_ptr<PipelineLayoutCache> m_pipelineLayouts;
+
+    PFN_vkCmdDrawIndexedIndirectCountKHR m_cmdDrawIndexedIndirectCount{ nullptr };
 
     void createInstance();
     void setupDebugMessenger();
     void createSurface();
     void pickPhysicalDevice();
     void createLogicalDevice();
+    void createAllocator();
+    void createPipelineCache();
+    void createDescriptors();
     void createCommandPool();
+    void createUploader();
 
     bool isDeviceSuitable(VkPhysicalDevice device);
     std::vector<const char*> getRequiredExtensions();
@@ -88,10 +158,11 @@ private:
     void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
     void hasGlfwRequiredInstanceExtensions();
     bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+    bool isDeviceExtensionAvailable(const char* extensionName);
     SwapchainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
     const std::vector<const char*> validationLayers{ "VK_LAYER_KHRONOS_validation" };
-    const std::vector<const char*> deviceExtensions{ VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    std::vector<const char*> deviceExtensions;
 };
 
 #endif //!DEVICE_HPP
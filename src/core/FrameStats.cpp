@@ -0,0 +1,136 @@
+#include "FrameStats.hpp"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <utility>
+
+namespace
+{
+    constexpr std::array<std::pair<const char*, double FrameTiming::*>, 8> fields{{
+        { "fenceWaitMs", &FrameTiming::fenceWaitMs },
+        { "acquireMs", &FrameTiming::acquireMs },
+        { "sceneMs", &FrameTiming::sceneMs },
+        { "recordMs", &FrameTiming::recordMs },
+        { "submitMs", &FrameTiming::submitMs },
+        { "cpuFrameMs", &FrameTiming::cpuFrameMs },
+        { "gpuMs", &FrameTiming::gpuMs },
+        { "inputToGpuDoneMs", &FrameTiming::inputToGpuDoneMs }
+    }};
+}
+
+template<typename F>
+void FrameStats::forEach(F&& function) const
+{
+    size_t oldest{ (m_next + HISTORY_SIZE - m_count) % HISTORY_SIZE };
+    for(size_t i{ 0 }; i < m_count; ++i)
+        function(m_history[(oldest + i) % HISTORY_SIZE]);
+}
+
+FrameStats::FrameStats()
+    : m_history(HISTORY_SIZE)
+{
+}
+
+void FrameStats::push(const FrameTiming& timing)
+{
+    m_history[m_next] = timing;
+    m_next = (m_next + 1) % HISTORY_SIZE;
+    m_count = std::min(m_count + 1, HISTORY_SIZE);
+}
+
+FrameTiming* FrameStats::find(uint64_t frame)
+{
+    // the results arrive a couple of frames late, the entry is usually close to the head
+    for(size_t i{ 1 }; i <= m_count; ++i)
+    {
+        FrameTiming& timing{ m_history[(m_next + HISTORY_SIZE - i) % HISTORY_SIZE] };
+        if(timing.frame == frame)
+            return &timing;
+    }
+
+    return nullptr;
+}
+
+void FrameStats::setGpuTime(uint64_t frame, double gpuMs)
+{
+    if(FrameTiming* timing{ find(frame) })
+        timing->gpuMs = gpuMs;
+}
+
+void FrameStats::setInputToGpuDone(uint64_t frame, double inputToGpuDoneMs)
+{
+    if(FrameTiming* timing{ find(frame) })
+        timing->inputToGpuDoneMs = inputToGpuDoneMs;
+}
+
+FrameStats::Summary FrameStats::summarize(double FrameTiming::* field) const
+{
+    std::vector<double> values;
+    values.reserve(m_count);
+    forEach([&](const FrameTiming& timing) {
+        if(timing.*field >= 0.0)
+            values.push_back(timing.*field);
+    });
+
+    if(values.empty())
+        return {};
+
+    Summary summary{
+        .min = *std::min_element(values.begin(), values.end()),
+        .avg = std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size())
+    };
+
+    size_t p99Index{ (values.size() * 99) / 100 };
+    std::nth_element(values.begin(), values.begin() + p99Index, values.end());
+    summary.p99 = values[p99Index];
+
+    return summary;
+}
+
+void FrameStats::writeSummary(std::ostream& out) const
+{
+    out << "frame stats over the last " << m_count << " frames (min / avg / p99 ms):";
+    for(const auto& [name, field]: fields)
+    {
+        Summary summary{ summarize(field) };
+        out << "\n\t" << name << ": " << summary.min << " / " << summary.avg << " / " << summary.p99;
+    }
+}
+
+void FrameStats::writeCsv(std::ostream& out) const
+{
+    out << "frame";
+    for(const auto& [name, field]: fields)
+        out << ',' << name;
+    out << '\n';
+
+    forEach([&](const FrameTiming& timing) {
+        out << timing.frame;
+        for(const auto& [name, field]: fields)
+            out << ',' << timing.*field;
+        out << '\n';
+    });
+}
+
+void FrameStats::writeJson(std::ostream& out) const
+{
+    out << "{\n  \"summary\": {";
+    for(size_t i{ 0 }; i < fields.size(); ++i)
+    {
+        Summary summary{ summarize(fields[i].second) };
+        out << (i == 0 ? "\n" : ",\n") << "    \"" << fields[i].first << "\": { \"min\": " << summary.min << ", \"avg\": " << summary.avg << ", \"p99\": " << summary.p99 << " }";
+    }
+
+    out << "\n  },\n  \"frames\": [";
+    bool first{ true };
+    forEach([&](const FrameTiming& timing) {
+        out << (first ? "\n" : ",\n") << "    { \"frame\": " << timing.frame;
+        for(const auto& [name, field]: fields)
+            out << ", \"" << name << "\": " << timing.*field;
+        out << " }";
+        first = false;
+    });
+
+    out << "\n  ]\n}\n";
+}
@@ -0,0 +1,66 @@
+#ifndef CORE_FRAME_STATS_HPP
+#define CORE_FRAME_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+struct FrameTiming
+{
+    uint64_t frame{ 0 };
+    double fenceWaitMs{ 0.0 };
+    double acquireMs{ 0.0 };
+    // culling the scene or writing its transforms for the frame, not part of recordMs
+    double sceneMs{ 0.0 };
+    double recordMs{ 0.0 };
+    double submitMs{ 0.0 };
+    double cpuFrameMs{ 0.0 };
+    // filled in once the frame's timestamp queries are available, negative until then
+    double gpuMs{ -1.0 };
+    // input sampling until the CPU saw the frame's fence signaled, known once that fence is waited on again
+    // not an input to present latency: the present and scanout come later, one or more vblanks with FIFO or MAILBOX,
+    // and when the fence had already signaled the time the frame sat until its slot came around is included
+    double inputToGpuDoneMs{ -1.0 };
+};
+
+/*
+ * Ring buffer over the last HISTORY_SIZE frames.
+ * Summaries are computed over the whole window, so they roll along with the ring.
+ */
+class FrameStats
+{
+public:
+    static constexpr size_t HISTORY_SIZE{ 1024 };
+
+    struct Summary
+    {
+        double min{ 0.0 };
+        double avg{ 0.0 };
+        double p99{ 0.0 };
+    };
+
+    FrameStats();
+
+    void push(const FrameTiming& timing);
+    void setGpuTime(uint64_t frame, double gpuMs);
+    void setInputToGpuDone(uint64_t frame, double inputToGpuDoneMs);
+
+    size_t size() const { return m_count; }
+    Summary summarize(double FrameTiming::* field) const;
+
+    void writeSummary(std::ostream& out) const;
+    void writeCsv(std::ostream& out) const;
+    void writeJson(std::ostream& out) const;
+
+private:
+    std::vector<FrameTiming> m_history;
+    size_t m_next{ 0 };
+    size_t m_count{ 0 };
+
+    template<typename F>
+    void forEach(F&& function) const;
+    FrameTiming* find(uint64_t frame);
+};
+
+#endif //!CORE_FRAME_STATS_HPP
@@ -0,0 +1,69 @@
+#include "GpuTimer.hpp"
+
+#include <array>
+#include <iostream>
+#include <stdexcept>
+#include <vulkan/vulkan_core.h>
+
+GpuTimer::GpuTimer(Device& device, uint32_t slotCount)
+    : device(device), m_timestampPeriod(device.properties.limits.timestampPeriod), m_slotCount(slotCount), m_written(slotCount, false)
+{
+    // only the graphics queue is timed, timestampComputeAndGraphics would demand support on every queue
+    uint32_t validBits{ device.graphicsTimestampValidBits() };
+    if(validBits == 0)
+    {
+        std::clog << "GPU timestamps are not supported, frame stats will only contain CPU timings" << std::endl;
+        return;
+    }
+
+    m_validMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+
+    VkQueryPoolCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = slotCount * 2
+    };
+
+    if(vkCreateQueryPool(device.device(), &createInfo, nullptr, &m_queryPool) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating timestamp query pool");
+}
+
+GpuTimer::~GpuTimer()
+{
+    if(m_queryPool != VK_NULL_HANDLE)
+        vkDestroyQueryPool(device.device(), m_queryPool, nullptr);
+}
+
+void GpuTimer::begin(VkCommandBuffer commandBuffer, uint32_t slot)
+{
+    if(!isSupported())
+        return;
+
+    vkCmdResetQueryPool(commandBuffer, m_queryPool, slot * 2, 2);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, slot * 2);
+}
+
+void GpuTimer::end(VkCommandBuffer commandBuffer, uint32_t slot)
+{
+    if(!isSupported())
+        return;
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, slot * 2 + 1);
+    m_written[slot] = true;
+}
+
+std::optional<double> GpuTimer::read(uint32_t slot)
+{
+    if(!isSupported() || !m_written[slot])
+        return std::nullopt;
+
+    std::array<uint64_t, 2> timestamps;
+    VkResult result{ vkGetQueryPoolResults(device.device(), m_queryPool, slot * 2, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) };
+    if(result != VK_SUCCESS)
+        return std::nullopt;
+
+    m_written[slot] = false;
+    uint64_t ticks{ (timestamps[1] - timestamps[0]) & m_validMask };
+
+    return static_cast<double>(ticks) * m_timestampPeriod / 1'000'000.0;
+}
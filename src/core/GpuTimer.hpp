@@ -0,0 +1,40 @@
+#ifndef CORE_GPU_TIMER_HPP
+#define CORE_GPU_TIMER_HPP
+
+#include "Device.hpp"
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/*
+ * Pair of timestamp queries per slot (usually one slot per frame in flight).
+ * A slot may only be read back after the submission that wrote it has completed.
+ */
+class GpuTimer
+{
+public:
+    GpuTimer(Device& device, uint32_t slotCount);
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    bool isSupported() const { return m_queryPool != VK_NULL_HANDLE; }
+
+    void begin(VkCommandBuffer commandBuffer, uint32_t slot);
+    void end(VkCommandBuffer commandBuffer, uint32_t slot);
+    std::optional<double> read(uint32_t slot);
+
+private:
+    Device& device;
+    VkQueryPool m_queryPool{ VK_NULL_HANDLE };
+    double m_timestampPeriod;
+    uint64_t m_validMask{ 0 };
+    uint32_t m_slotCount;
+    std::vector<bool> m_written;
+};
+
+#endif //!CORE_GPU_TIMER_HPP
@@ -0,0 +1,186 @@
+#include "IndirectRenderer.hpp"
+#include "SceneCuller.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vulkan/vulkan_core.h>
+
+IndirectRenderer::IndirectRenderer(Device& device, Model& model, uint32_t framesInFlight, uint32_t maxObjects,
+    const std::filesystem::path& vertFilepath, const std::filesystem::path& fragFilepath)
+    : device(device), m_model(model), m_maxObjects(maxObjects)
+{
+    if(!isSupported(device))
+        throw std::runtime_error("Failure while creating indirect renderer: drawIndirectFirstInstance is not supported");
+
+    if(device.enabledFeatures.multiDrawIndirect && maxObjects > device.properties.limits.maxDrawIndirectCount)
+        throw std::runtime_error("Failure while creating indirect renderer: more objects than maxDrawIndirectCount");
+
+    createBuffers(framesInFlight);
+    createPipelineLayouts(vertFilepath, fragFilepath);
+    createDescriptorSets();
+
+    m_cullPipeline = std::make_unique<ComputePipeline>(device, CULL_SHADER, m_cullPipelineLayout);
+}
+
+IndirectRenderer::~IndirectRenderer()
+{
+    m_cullPipeline.reset();
+
+    for(auto& frame: m_frames)
+    {
+        device.destroyBuffer(frame.objects, frame.objectMemory);
+        device.destroyBuffer(frame.drawCommands, frame.drawCommandsMemory);
+        device.destroyBuffer(frame.drawCount, frame.drawCountMemory);
+    }
+}
+
+void IndirectRenderer::setObjectCount(uint32_t frame, uint32_t count)
+{
+    if(count > m_maxObjects)
+        throw std::runtime_error("Failure while setting indirect objects: more objects than the renderer was created for");
+
+    m_frames[frame].objectCount = count;
+}
+
+void IndirectRenderer::cull(VkCommandBuffer commandBuffer, uint32_t frame, const glm::mat4& viewProjection)
+{
+    FrameResources& resources{ m_frames[frame] };
+    m_viewProjection = viewProjection;
+
+    // without a count buffer every command up to the object count is executed, culled slots have to stay zero instances
+    vkCmdFillBuffer(commandBuffer, resources.drawCount, 0, sizeof(uint32_t), 0);
+    if(!device.supportsDrawIndirectCount())
+        vkCmdFillBuffer(commandBuffer, resources.drawCommands, 0, VK_WHOLE_SIZE, 0);
+
+    VkMemoryBarrier clearBarrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+    };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clearBarrier, 0, nullptr, 0, nullptr);
+
+    CullConstants constants{
+        .frustumPlanes = Frustum::fromViewProjection(viewProjection).planes,
+        .objectCount = resources.objectCount,
+        .indexCount = m_model.indexCount()
+    };
+
+    m_cullPipeline->bind(commandBuffer);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPipelineLayout, 0, 1, &resources.cullSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, m_cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullConstants), &constants);
+    m_cullPipeline->dispatch(commandBuffer, (resources.objectCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE);
+
+    ComputePipeline::barrier(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+}
+
+void IndirectRenderer::draw(VkCommandBuffer commandBuffer, uint32_t frame)
+{
+    FrameResources& resources{ m_frames[frame] };
+    if(resources.objectCount == 0)
+        return;
+
+    constexpr uint32_t stride{ sizeof(VkDrawIndexedIndirectCommand) };
+
+    m_model.bind(commandBuffer);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipelineLayout, 0, 1, &resources.objectSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, m_graphicsPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &m_viewProjection);
+
+    if(device.supportsDrawIndirectCount())
+        device.cmdDrawIndexedIndirectCount(commandBuffer, resources.drawCommands, 0, resources.drawCount, 0, resources.objectCount, stride);
+    else if(device.enabledFeatures.multiDrawIndirect)
+        vkCmdDrawIndexedIndirect(commandBuffer, resources.drawCommands, 0, resources.objectCount, stride);
+    else
+    {
+        // one call per command, still no per object work on the CPU beyond the call itself
+        for(uint32_t i{ 0 }; i < resources.objectCount; ++i)
+            vkCmdDrawIndexedIndirect(commandBuffer, resources.drawCommands, static_cast<VkDeviceSize>(i) * stride, 1, stride);
+    }
+}
+
+void IndirectRenderer::createBuffers(uint32_t framesInFlight)
+{
+    // at least one element, zero sized buffers are not allowed
+    VkDeviceSize objectCapacity{ std::max(m_maxObjects, 1u) };
+
+    m_frames.resize(framesInFlight);
+    for(auto& frame: m_frames)
+    {
+        // rewritten by the CPU every frame and read once by the culling and once per visible object, not worth a copy
+        device.createBuffer(sizeof(ObjectData) * objectCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.objects, frame.objectMemory);
+
+        if(frame.objectMemory.mapped == nullptr)
+            throw std::runtime_error("Failure while creating indirect renderer: object memory is not mapped");
+
+        device.createBuffer(sizeof(VkDrawIndexedIndirectCommand) * objectCapacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.drawCommands, frame.drawCommandsMemory);
+
+        device.createBuffer(sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.drawCount, frame.drawCountMemory);
+    }
+}
+
+void IndirectRenderer::createDescriptorSets()
+{
+    // written once and used until shutdown
+    DescriptorAllocator& allocator{ device.descriptorAllocator() };
+
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    std::vector<VkWriteDescriptorSet> writes;
+    // the writes point into bufferInfos, it must not reallocate
+    bufferInfos.reserve(m_frames.size() * 3);
+
+    for(auto& frame: m_frames)
+    {
+        frame.cullSet = allocator.allocate(m_cullSetLayout);
+        frame.objectSet = allocator.allocate(m_objectSetLayout);
+
+        bufferInfos.push_back({ .buffer = frame.objects, .offset = 0, .range = VK_WHOLE_SIZE });
+        bufferInfos.push_back({ .buffer = frame.drawCommands, .offset = 0, .range = VK_WHOLE_SIZE });
+        bufferInfos.push_back({ .buffer = frame.drawCount, .offset = 0, .range = VK_WHOLE_SIZE });
+        const VkDescriptorBufferInfo* frameInfos{ &bufferInfos[bufferInfos.size() - 3] };
+
+        writes.push_back(VkWriteDescriptorSet{
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = frame.objectSet,
+            .dstBinding = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &frameInfos[0]
+        });
+
+        for(uint32_t binding{ 0 }; binding < 3; ++binding)
+        {
+            writes.push_back(VkWriteDescriptorSet{
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = frame.cullSet,
+                .dstBinding = binding,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &frameInfos[binding]
+            });
+        }
+    }
+
+    vkUpdateDescriptorSets(device.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void IndirectRenderer::createPipelineLayouts(const std::filesystem::path& vertFilepath, const std::filesystem::path& fragFilepath)
+{
+    PipelineLayoutCache& layouts{ device.pipelineLayouts() };
+
+    PipelineLayoutCache::Layout cullLayout{ layouts.get(ShaderReflection::reflectFiles({ CULL_SHADER })) };
+    if(cullLayout.setLayouts.size() != 1 || cullLayout.pushConstants.size != sizeof(CullConstants))
+        throw std::runtime_error("Failure while creating indirect renderer: the cull shader doesn't match CullConstants");
+
+    m_cullPipelineLayout = cullLayout.handle;
+    m_cullSetLayout = cullLayout.setLayouts[0];
+
+    PipelineLayoutCache::Layout graphicsLayout{ layouts.get(ShaderReflection::reflectFiles({ vertFilepath, fragFilepath })) };
+    if(graphicsLayout.setLayouts.size() != 1 || graphicsLayout.pushConstants.size != sizeof(glm::mat4) || graphicsLayout.pushConstants.stageFlags != VK_SHADER_STAGE_VERTEX_BIT)
+        throw std::runtime_error("Failure while creating indirect renderer: the vertex shader doesn't take the view projection as push constant");
+
+    m_graphicsPipelineLayout = graphicsLayout.handle;
+    m_objectSetLayout = graphicsLayout.setLayouts[0];
+}
@@ -0,0 +1,98 @@
+#ifndef CORE_INDIRECT_RENDERER_HPP
+#define CORE_INDIRECT_RENDERER_HPP
+
+#include "Device.hpp"
+#include "MemoryAllocator.hpp"
+#include "ComputePipeline.hpp"
+#include "Model.hpp"
+#include "Scene.hpp"
+
+#include <vulkan/vulkan_core.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+/*
+ * GPU driven drawing of many instances of one model.
+ * A compute pass culls every object against the view frustum and appends a VkDrawIndexedIndirectCommand per visible
+ * object, the graphics pass then draws the whole list with a single indirect call, so the CPU cost doesn't depend on
+ * the object count. The objects, command list and counter exist once per frame in flight, the objects live in
+ * host visible memory the scene writes into directly.
+ */
+class IndirectRenderer
+{
+public:
+    static constexpr uint32_t WORKGROUP_SIZE{ 64 };
+
+    static constexpr const char* CULL_SHADER{ "shaders/cull.comp.spv" };
+
+    // the graphics shaders are only reflected for the layout, the pipeline itself is built by the caller
+    IndirectRenderer(Device& device, Model& model, uint32_t framesInFlight, uint32_t maxObjects,
+        const std::filesystem::path& vertFilepath, const std::filesystem::path& fragFilepath);
+    ~IndirectRenderer();
+
+    IndirectRenderer(const IndirectRenderer&) = delete;
+    IndirectRenderer& operator=(const IndirectRenderer&) = delete;
+
+    // the vertex shader identifies its object through firstInstance
+    static bool isSupported(Device& device) { return device.enabledFeatures.drawIndirectFirstInstance == VK_TRUE; }
+
+    // persistently mapped room for maxObjects(), only written after the frame's fence was waited on
+    ObjectData* objects(uint32_t frame) { return static_cast<ObjectData*>(m_frames[frame].objectMemory.mapped); }
+    // how many of the frame's objects were written
+    void setObjectCount(uint32_t frame, uint32_t count);
+
+    // recorded outside of a render pass before draw() of the same frame, either on the graphics queue
+    // or on the compute queue with the graphics submit waiting at VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT
+    void cull(VkCommandBuffer commandBuffer, uint32_t frame, const glm::mat4& viewProjection);
+    // recorded inside the render pass with a pipeline created from graphicsPipelineLayout() bound
+    void draw(VkCommandBuffer commandBuffer, uint32_t frame);
+
+    VkPipelineLayout graphicsPipelineLayout() const { return m_graphicsPipelineLayout; }
+    uint32_t maxObjects() const { return m_maxObjects; }
+
+private:
+    struct FrameResources
+    {
+        VkBuffer objects;
+        MemoryAllocation objectMemory;
+        uint32_t objectCount{ 0 };
+        VkDescriptorSet objectSet;
+        VkBuffer drawCommands;
+        MemoryAllocation drawCommandsMemory;
+        VkBuffer drawCount;
+        MemoryAllocation drawCountMemory;
+        VkDescriptorSet cullSet;
+    };
+
+    struct CullConstants
+    {
+        std::array<glm::vec4, 6> frustumPlanes;
+        uint32_t objectCount;
+        uint32_t indexCount;
+    };
+
+    Device& device;
+    Model& m_model;
+    uint32_t m_maxObjects;
+    glm::mat4 m_viewProjection{ 1.f };
+
+    std::vector<FrameResources> m_frames;
+
+    // owned by the device's layout caches
+    VkDescriptorSetLayout m_cullSetLayout;
+    VkDescriptorSetLayout m_objectSetLayout;
+    VkPipelineLayout m_cullPipelineLayout;
+    VkPipelineLayout m_graphicsPipelineLayout;
+    std::unique_ptr<ComputePipeline> m_cullPipeline;
+
+    void createBuffers(uint32_t framesInFlight);
+    void createDescriptorSets();
+    void createPipelineLayouts(const std::filesystem::path& vertFilepath, const std::filesystem::path& fragFilepath);
+};
+
+#endif //!CORE_INDIRECT_RENDERER_HPP
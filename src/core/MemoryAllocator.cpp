@@ -0,0 +1,340 @@
+#include "MemoryAllocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <stdexcept>
+#include <vulkan/vulkan_core.h>
+
+float MemoryStats::externalFragmentation() const
+{
+    VkDeviceSize freeBytes{ reservedBytes - allocatedBytes };
+    if(freeBytes == 0)
+        return 0.f;
+
+    return 1.f - static_cast<float>(largestFreeBlock) / static_cast<float>(freeBytes);
+}
+
+std::ostream& operator<<(std::ostream& out, const MemoryStats& stats)
+{
+    out << "device memory: " << stats.allocationCount << " allocations in " << stats.pageCount << " pages + " << stats.dedicatedCount << " dedicated" <<
+        "\n\t" << "reserved: " << stats.reservedBytes / 1024 << " KiB" <<
+        "\n\t" << "allocated: " << stats.allocatedBytes / 1024 << " KiB (" << stats.requestedBytes / 1024 << " KiB requested)" <<
+        "\n\t" << "largest free block: " << stats.largestFreeBlock / 1024 << " KiB" <<
+        "\n\t" << "internal fragmentation: " << stats.internalFragmentation() * 100.f << "%" <<
+        "\n\t" << "external fragmentation: " << stats.externalFragmentation() * 100.f << "%";
+
+    return out;
+}
+
+MemoryAllocator::MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device)
+    : m_device(device)
+{
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    m_bufferImageGranularity = properties.limits.bufferImageGranularity;
+    m_maxAllocationCount = properties.limits.maxMemoryAllocationCount;
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+    uint32_t leaked{ 0 };
+    for(auto& page: m_pages)
+    {
+        if(page.memory == VK_NULL_HANDLE)
+            continue;
+
+        leaked += page.allocationCount;
+        destroyPage(page);
+    }
+
+    if(leaked > 0)
+        std::clog << "MemoryAllocator: " << leaked << " allocations were not freed before shutdown" << std::endl;
+}
+
+MemoryAllocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceTiling tiling)
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    uint32_t memoryTypeIndex{ findMemoryType(requirements.memoryTypeBits, properties) };
+
+    // blocks are at least MIN_BLOCK_SIZE aligned, so with a small granularity two blocks never share a granularity page
+    if(m_bufferImageGranularity <= MIN_BLOCK_SIZE)
+        tiling = ResourceTiling::Linear;
+
+    uint32_t order{ orderFor(std::max(requirements.size, requirements.alignment)) };
+    VkDeviceSize pageSize{ pageSizeFor(memoryTypeIndex) };
+
+    MemoryAllocation allocation{};
+
+    if(blockSize(order) > pageSize / 2)
+    {
+        uint32_t pageIndex{ createPage(memoryTypeIndex, requirements.size, tiling, true) };
+        Page& page{ m_pages[pageIndex] };
+
+        page.allocationCount = 1;
+        page.requestedBytes = requirements.size;
+        page.allocatedBytes = requirements.size;
+
+        allocation.memory = page.memory;
+        allocation.offset = 0;
+        allocation.size = requirements.size;
+        allocation.mapped = page.mapped;
+        allocation.pageIndex = pageIndex;
+
+        return allocation;
+    }
+
+    for(uint32_t i{ 0 }; i < m_pages.size(); ++i)
+    {
+        Page& page{ m_pages[i] };
+        if(page.memory == VK_NULL_HANDLE || page.dedicated || page.memoryTypeIndex != memoryTypeIndex || page.tiling != tiling)
+            continue;
+
+        if(allocateFromPage(page, i, order, allocation))
+        {
+            allocation.size = requirements.size;
+            page.requestedBytes += requirements.size;
+            return allocation;
+        }
+    }
+
+    uint32_t pageIndex{ createPage(memoryTypeIndex, pageSize, tiling, false) };
+    Page& page{ m_pages[pageIndex] };
+
+    if(!allocateFromPage(page, pageIndex, order, allocation))
+        throw std::runtime_error("Failure while sub allocating from a fresh memory page");
+
+    allocation.size = requirements.size;
+    page.requestedBytes += requirements.size;
+
+    return allocation;
+}
+
+void MemoryAllocator::free(MemoryAllocation& allocation)
+{
+    if(!allocation.isValid())
+        return;
+
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    Page& page{ m_pages.at(allocation.pageIndex) };
+
+    if(page.dedicated)
+    {
+        destroyPage(page);
+        allocation = MemoryAllocation{};
+        return;
+    }
+
+    --page.allocationCount;
+    page.requestedBytes -= allocation.size;
+    page.allocatedBytes -= blockSize(allocation.order);
+
+    VkDeviceSize offset{ allocation.offset };
+    uint32_t order{ allocation.order };
+    uint32_t maxOrder{ static_cast<uint32_t>(page.freeBlocks.size() - 1) };
+
+    while(order < maxOrder)
+    {
+        auto buddy{ page.freeBlocks[order].find(offset ^ blockSize(order)) };
+        if(buddy == page.freeBlocks[order].end())
+            break;
+
+        offset = std::min(offset, *buddy);
+        page.freeBlocks[order].erase(buddy);
+        ++order;
+    }
+
+    page.freeBlocks[order].insert(offset);
+
+    if(page.allocationCount == 0)
+        releaseEmptyPage(allocation.pageIndex);
+
+    allocation = MemoryAllocation{};
+}
+
+MemoryStats MemoryAllocator::stats()
+{
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    MemoryStats stats{};
+    for(const auto& page: m_pages)
+    {
+        if(page.memory == VK_NULL_HANDLE)
+            continue;
+
+        if(page.dedicated)
+            ++stats.dedicatedCount;
+        else
+            ++stats.pageCount;
+
+        stats.allocationCount += page.allocationCount;
+        stats.reservedBytes += page.size;
+        stats.requestedBytes += page.requestedBytes;
+        stats.allocatedBytes += page.allocatedBytes;
+
+        for(size_t order{ page.freeBlocks.size() }; order > 0; --order)
+        {
+            if(!page.freeBlocks[order - 1].empty())
+            {
+                stats.largestFreeBlock = std::max(stats.largestFreeBlock, blockSize(static_cast<uint32_t>(order - 1)));
+                break;
+            }
+        }
+    }
+
+    return stats;
+}
+
+uint32_t MemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+{
+    for(uint32_t i{ 0 }; i < m_memoryProperties.memoryTypeCount; ++i)
+    {
+        if((typeFilter & (1 << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            return i;
+    }
+
+    throw std::runtime_error("Failed to find suitable memory type");
+}
+
+bool MemoryAllocator::hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+{
+    for(uint32_t i{ 0 }; i < m_memoryProperties.memoryTypeCount; ++i)
+    {
+        if((typeFilter & (1 << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            return true;
+    }
+
+    return false;
+}
+
+VkDeviceSize MemoryAllocator::pageSizeFor(uint32_t memoryTypeIndex)
+{
+    constexpr VkDeviceSize minPageSize{ 1024 * 1024 };
+
+    // small heaps (e.g. the 256 MiB BAR heap) should not be eaten up by a couple of pages
+    VkDeviceSize heapSize{ m_memoryProperties.memoryHeaps[m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size };
+    VkDeviceSize pageSize{ DEFAULT_PAGE_SIZE };
+    while(pageSize > minPageSize && pageSize * 8 > heapSize)
+        pageSize /= 2;
+
+    return pageSize;
+}
+
+uint32_t MemoryAllocator::createPage(uint32_t memoryTypeIndex, VkDeviceSize size, ResourceTiling tiling, bool dedicated)
+{
+    if(m_liveAllocationCount >= m_maxAllocationCount)
+        throw std::runtime_error("Failure while allocating memory: maxMemoryAllocationCount reached");
+
+    Page page{
+        .size = size,
+        .memoryTypeIndex = memoryTypeIndex,
+        .tiling = tiling,
+        .dedicated = dedicated
+    };
+
+    VkMemoryAllocateInfo allocInfo{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = size,
+        .memoryTypeIndex = memoryTypeIndex
+    };
+
+    if(vkAllocateMemory(m_device, &allocInfo, nullptr, &page.memory) != VK_SUCCESS)
+        throw std::runtime_error("Failure while allocating a memory page");
+    ++m_liveAllocationCount;
+
+    if(m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        if(vkMapMemory(m_device, page.memory, 0, VK_WHOLE_SIZE, 0, &page.mapped) != VK_SUCCESS)
+            throw std::runtime_error("Failure while mapping a memory page");
+    }
+
+    if(!dedicated)
+    {
+        uint32_t maxOrder{ orderFor(size) };
+        page.freeBlocks.resize(maxOrder + 1);
+        page.freeBlocks[maxOrder].insert(0);
+    }
+
+    auto slot{ std::find_if(m_pages.begin(), m_pages.end(), [](const Page& p) { return p.memory == VK_NULL_HANDLE; }) };
+    if(slot != m_pages.end())
+    {
+        *slot = std::move(page);
+        return static_cast<uint32_t>(slot - m_pages.begin());
+    }
+
+    m_pages.push_back(std::move(page));
+    return static_cast<uint32_t>(m_pages.size() - 1);
+}
+
+void MemoryAllocator::destroyPage(Page& page)
+{
+    if(page.mapped != nullptr)
+        vkUnmapMemory(m_device, page.memory);
+
+    vkFreeMemory(m_device, page.memory, nullptr);
+    --m_liveAllocationCount;
+
+    page = Page{};
+}
+
+bool MemoryAllocator::allocateFromPage(Page& page, uint32_t pageIndex, uint32_t order, MemoryAllocation& allocation)
+{
+    uint32_t found{ order };
+    while(found < page.freeBlocks.size() && page.freeBlocks[found].empty())
+        ++found;
+
+    if(found >= page.freeBlocks.size())
+        return false;
+
+    VkDeviceSize offset{ *page.freeBlocks[found].begin() };
+    page.freeBlocks[found].erase(page.freeBlocks[found].begin());
+
+    while(found > order)
+    {
+        --found;
+        page.freeBlocks[found].insert(offset + blockSize(found));
+    }
+
+    ++page.allocationCount;
+    page.allocatedBytes += blockSize(order);
+
+    allocation.memory = page.memory;
+    allocation.offset = offset;
+    allocation.mapped = page.mapped != nullptr ? static_cast<char*>(page.mapped) + offset : nullptr;
+    allocation.pageIndex = pageIndex;
+    allocation.order = order;
+
+    return true;
+}
+
+bool MemoryAllocator::releaseEmptyPage(uint32_t pageIndex)
+{
+    const Page& empty{ m_pages[pageIndex] };
+
+    // keep one empty page per memory type around, so alternating create/destroy does not hit the driver every time
+    for(uint32_t i{ 0 }; i < m_pages.size(); ++i)
+    {
+        const Page& page{ m_pages[i] };
+        if(i == pageIndex || page.memory == VK_NULL_HANDLE || page.dedicated)
+            continue;
+
+        if(page.memoryTypeIndex == empty.memoryTypeIndex && page.tiling == empty.tiling && page.allocationCount == 0)
+        {
+            destroyPage(m_pages[pageIndex]);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t MemoryAllocator::orderFor(VkDeviceSize size)
+{
+    VkDeviceSize rounded{ std::bit_ceil(std::max(size, MIN_BLOCK_SIZE)) };
+
+    return static_cast<uint32_t>(std::countr_zero(rounded / MIN_BLOCK_SIZE));
+}
@@ -0,0 +1,116 @@
+#ifndef CORE_MEMORY_ALLOCATOR_HPP
+#define CORE_MEMORY_ALLOCATOR_HPP
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <vector>
+
+enum class ResourceTiling
+{
+    Linear,
+    Optimal
+};
+
+/*
+ * Handle to a range of device memory handed out by the MemoryAllocator.
+ * Bind resources with memory + offset, return the range with MemoryAllocator::free().
+ * mapped is non null for host visible memory, the pages of those types are mapped once on creation.
+ */
+struct MemoryAllocation
+{
+    VkDeviceMemory memory{ VK_NULL_HANDLE };
+    VkDeviceSize offset{ 0 };
+    VkDeviceSize size{ 0 };
+    void* mapped{ nullptr };
+
+    uint32_t pageIndex{ 0 };
+    uint32_t order{ 0 };
+
+    bool isValid() const { return memory != VK_NULL_HANDLE; }
+};
+
+struct MemoryStats
+{
+    uint32_t pageCount{ 0 };
+    uint32_t dedicatedCount{ 0 };
+    uint32_t allocationCount{ 0 };
+    VkDeviceSize reservedBytes{ 0 };
+    VkDeviceSize requestedBytes{ 0 };
+    VkDeviceSize allocatedBytes{ 0 };
+    VkDeviceSize largestFreeBlock{ 0 };
+
+    // share of the handed out blocks that is lost to power of two rounding
+    float internalFragmentation() const { return allocatedBytes == 0 ? 0.f : 1.f - static_cast<float>(requestedBytes) / static_cast<float>(allocatedBytes); }
+    // share of the free memory that can not be handed out as one block
+    float externalFragmentation() const;
+};
+
+std::ostream& operator<<(std::ostream& out, const MemoryStats& stats);
+
+/*
+ * Buddy allocator that splits big VkDeviceMemory pages per memory type into power of two blocks.
+ * Blocks are aligned to their own size, so every alignment up to the block size is satisfied for free.
+ * Linear and optimal resources are kept in separate pages when bufferImageGranularity requires it.
+ * Requests larger than half a page get a dedicated allocation.
+ */
+class MemoryAllocator
+{
+public:
+    static constexpr VkDeviceSize DEFAULT_PAGE_SIZE{ 64ull * 1024 * 1024 };
+    static constexpr VkDeviceSize MIN_BLOCK_SIZE{ 256 };
+
+    MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device);
+    ~MemoryAllocator();
+
+    MemoryAllocator(const MemoryAllocator&) = delete;
+    MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+    MemoryAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceTiling tiling);
+    void free(MemoryAllocation& allocation);
+
+    // whether allocate() would find a memory type, e.g. to prefer LAZILY_ALLOCATED where it exists
+    bool hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+    MemoryStats stats();
+
+private:
+    struct Page
+    {
+        VkDeviceMemory memory{ VK_NULL_HANDLE };
+        VkDeviceSize size{ 0 };
+        void* mapped{ nullptr };
+        uint32_t memoryTypeIndex{ 0 };
+        ResourceTiling tiling{ ResourceTiling::Linear };
+        bool dedicated{ false };
+
+        uint32_t allocationCount{ 0 };
+        VkDeviceSize requestedBytes{ 0 };
+        VkDeviceSize allocatedBytes{ 0 };
+        std::vector<std::set<VkDeviceSize>> freeBlocks;
+    };
+
+    VkDevice m_device;
+    VkPhysicalDeviceMemoryProperties m_memoryProperties;
+    VkDeviceSize m_bufferImageGranularity;
+    uint32_t m_maxAllocationCount;
+
+    std::vector<Page> m_pages;
+    uint32_t m_liveAllocationCount{ 0 };
+    std::mutex m_mutex;
+
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+    VkDeviceSize pageSizeFor(uint32_t memoryTypeIndex);
+    uint32_t createPage(uint32_t memoryTypeIndex, VkDeviceSize size, ResourceTiling tiling, bool dedicated);
+    void destroyPage(Page& page);
+    bool allocateFromPage(Page& page, uint32_t pageIndex, uint32_t order, MemoryAllocation& allocation);
+    bool releaseEmptyPage(uint32_t pageIndex);
+
+    static uint32_t orderFor(VkDeviceSize size);
+    static VkDeviceSize blockSize(uint32_t order) { return MIN_BLOCK_SIZE << order; }
+};
+
+#endif //!CORE_MEMORY_ALLOCATOR_HPP
@@ -0,0 +1,142 @@
+#include "Model.hpp"
+#include "Uploader.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vulkan/vulkan_core.h>
+
+namespace
+{
+    struct VertexAttributes
+    {
+        glm::vec3 color;
+    };
+}
+
+Model::Model(Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, VertexLayout layout)
+    : device(device), m_layout(layout), m_indexCount(static_cast<uint32_t>(indices.size()))
+{
+    if(vertices.empty() || indices.empty())
+        throw std::runtime_error("Failure while creating model: no vertices or indices");
+
+    if(layout == VertexLayout::Interleaved)
+        m_vertexBuffer = createDeviceLocalBuffer(vertices.data(), sizeof(Vertex) * vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, m_vertexMemory);
+    else
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<VertexAttributes> attributes;
+        positions.reserve(vertices.size());
+        attributes.reserve(vertices.size());
+
+        for(const auto& vertex: vertices)
+        {
+            positions.push_back(vertex.position);
+            attributes.push_back(VertexAttributes{ .color = vertex.color });
+        }
+
+        // the uploader copies the data into its staging memory right away, the temporaries can go out of scope
+        m_vertexBuffer = createDeviceLocalBuffer(positions.data(), sizeof(glm::vec3) * positions.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, m_vertexMemory);
+        m_attributeBuffer = createDeviceLocalBuffer(attributes.data(), sizeof(VertexAttributes) * attributes.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, m_attributeMemory);
+    }
+
+    m_indexBuffer = createDeviceLocalBuffer(indices.data(), sizeof(uint32_t) * indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, m_indexMemory);
+}
+
+Model::~Model()
+{
+    device.destroyBuffer(m_vertexBuffer, m_vertexMemory);
+    if(m_attributeBuffer != VK_NULL_HANDLE)
+        device.destroyBuffer(m_attributeBuffer, m_attributeMemory);
+    device.destroyBuffer(m_indexBuffer, m_indexMemory);
+}
+
+VkBuffer Model::createDeviceLocalBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, MemoryAllocation& memory)
+{
+    VkBuffer buffer;
+    device.createBuffer(size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, memory);
+
+    // all buffers of the model land in the same batch, so the last ticket covers them all
+    m_uploadTicket = device.uploader().uploadBuffer(data, size, buffer);
+
+    return buffer;
+}
+
+VertexInputDescription Model::vertexInputDescription(VertexLayout layout, bool positionOnly)
+{
+    VertexInputDescription description;
+
+    if(layout == VertexLayout::Interleaved)
+    {
+        description.bindings.push_back({ .binding = 0, .stride = sizeof(Vertex), .inputRate = VK_VERTEX_INPUT_RATE_VERTEX });
+        description.attributes.push_back({ .location = 0, .binding = 0, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = offsetof(Vertex, position) });
+
+        if(!positionOnly)
+            description.attributes.push_back({ .location = 1, .binding = 0, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = offsetof(Vertex, color) });
+    }
+    else
+    {
+        description.bindings.push_back({ .binding = 0, .stride = sizeof(glm::vec3), .inputRate = VK_VERTEX_INPUT_RATE_VERTEX });
+        description.attributes.push_back({ .location = 0, .binding = 0, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = 0 });
+
+        if(!positionOnly)
+        {
+            description.bindings.push_back({ .binding = 1, .stride = sizeof(VertexAttributes), .inputRate = VK_VERTEX_INPUT_RATE_VERTEX });
+            description.attributes.push_back({ .location = 1, .binding = 1, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = offsetof(VertexAttributes, color) });
+        }
+    }
+
+    return description;
+}
+
+VertexInputDescription Model::vertexInputDescription(VertexLayout layout, const ShaderReflection& vertexShader)
+{
+    VertexInputDescription available{ vertexInputDescription(layout) };
+    VertexInputDescription description;
+
+    // the model stores floats only, an integer input would read garbage
+    auto isInteger{ [](VkFormat format) {
+        return format != VK_FORMAT_R32_SFLOAT && format != VK_FORMAT_R32G32_SFLOAT && format != VK_FORMAT_R32G32B32_SFLOAT && format != VK_FORMAT_R32G32B32A32_SFLOAT;
+    } };
+
+    for(const auto& input: vertexShader.vertexInputs)
+    {
+        auto attribute{ std::find_if(available.attributes.begin(), available.attributes.end(), [&input](const auto& attribute) {
+            return attribute.location == input.location;
+        }) };
+
+        if(attribute == available.attributes.end() || isInteger(input.format))
+            throw std::runtime_error("Failure while matching vertex input: the model provides no float attribute at location " + std::to_string(input.location));
+
+        description.attributes.push_back(*attribute);
+    }
+
+    for(const auto& binding: available.bindings)
+    {
+        bool used{ std::any_of(description.attributes.begin(), description.attributes.end(), [&binding](const auto& attribute) {
+            return attribute.binding == binding.binding;
+        }) };
+
+        if(used)
+            description.bindings.push_back(binding);
+    }
+
+    return description;
+}
+
+void Model::bind(VkCommandBuffer commandBuffer, bool positionOnly)
+{
+    std::array<VkBuffer, 2> buffers{ m_vertexBuffer, m_attributeBuffer };
+    std::array<VkDeviceSize, 2> offsets{ 0, 0 };
+    uint32_t bindingCount{ m_layout == VertexLayout::Split && !positionOnly ? 2u : 1u };
+
+    vkCmdBindVertexBuffers(commandBuffer, 0, bindingCount, buffers.data(), offsets.data());
+    vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+}
+
+void Model::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount)
+{
+    vkCmdDrawIndexed(commandBuffer, m_indexCount, instanceCount, 0, 0, 0);
+}
@@ -0,0 +1,80 @@
+#ifndef CORE_MODEL_HPP
+#define CORE_MODEL_HPP
+
+#include "Device.hpp"
+#include "MemoryAllocator.hpp"
+#include "ShaderReflection.hpp"
+
+#include <vulkan/vulkan_core.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+enum class VertexLayout
+{
+    // a single binding with position and attributes interleaved
+    Interleaved,
+    // positions in binding 0 and the remaining attributes in binding 1, so position only passes fetch a tightly packed stream
+    Split
+};
+
+struct VertexInputDescription
+{
+    std::vector<VkVertexInputBindingDescription> bindings;
+    std::vector<VkVertexInputAttributeDescription> attributes;
+};
+
+/*
+ * Indexed geometry living in device local memory.
+ * The vertex and index data is staged through the device's uploader once at construction,
+ * it may only be drawn after uploadTicket() has completed.
+ */
+class Model
+{
+public:
+    struct Vertex
+    {
+        glm::vec3 position;
+        glm::vec3 color;
+    };
+
+    Model(Device& device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, VertexLayout layout = VertexLayout::Interleaved);
+    ~Model();
+
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    // binding and attribute descriptions for PipelineConfigInfo, positionOnly leaves out everything but location 0
+    static VertexInputDescription vertexInputDescription(VertexLayout layout, bool positionOnly = false);
+    // only the attributes the vertex shader reads, throws when it reads a location the model doesn't provide
+    static VertexInputDescription vertexInputDescription(VertexLayout layout, const ShaderReflection& vertexShader);
+
+    void bind(VkCommandBuffer commandBuffer, bool positionOnly = false);
+    void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1);
+
+    VertexLayout layout() const { return m_layout; }
+    uint32_t indexCount() const { return m_indexCount; }
+    UploadTicket uploadTicket() const { return m_uploadTicket; }
+
+private:
+    Device& device;
+    VertexLayout m_layout;
+
+    // interleaved vertices, or only the positions for the split layout
+    VkBuffer m_vertexBuffer;
+    MemoryAllocation m_vertexMemory;
+    // the non position attributes of the split layout
+    VkBuffer m_attributeBuffer{ VK_NULL_HANDLE };
+    MemoryAllocation m_attributeMemory;
+
+    VkBuffer m_indexBuffer;
+    MemoryAllocation m_indexMemory;
+    uint32_t m_indexCount;
+
+    UploadTicket m_uploadTicket{ 0 };
+
+    VkBuffer createDeviceLocalBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, MemoryAllocation& memory);
+};
+
+#endif //!CORE_MODEL_HPP
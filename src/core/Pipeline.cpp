@@ -1,6 +1,7 @@
 #include "Pipeline.hpp"
 
 #include <cassert>
+#include <chrono>
 #include <fstream>
 #include <stdexcept>
 #include <iostream>
@@ -9,95 +10,123 @@
 Pipeline::Pipeline(Device& device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo)
     : device(device)
 {
-    assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "Cannot craete graphics pipeline: no pipelineLayout provided");
-    assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot craete graphics pipeline: no renderPass provided");
+    using Milliseconds = std::chrono::duration<double, std::milli>;
 
+    auto shaderStart{ std::chrono::steady_clock::now() };
     createShaderModule(readFile(vertFilepath), &m_vertShaderModule);
     createShaderModule(readFile(fragFilepath), &m_fragShaderModule);
+    m_timings.shaderModulesMs = Milliseconds(std::chrono::steady_clock::now() - shaderStart).count();
+
+    GraphicsPipelineState state{ configInfo, m_vertShaderModule, m_fragShaderModule };
+
+    PipelineCache& pipelineCache{ device.pipelineCache() };
+    auto start{ std::chrono::steady_clock::now() };
+
+    if(vkCreateGraphicsPipelines(device.device(), pipelineCache.handle(), 1, &state.createInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating graphics pipeline");
+
+    auto duration{ std::chrono::steady_clock::now() - start };
+    pipelineCache.recordCreation(duration);
+    m_timings.createPipelineMs = Milliseconds(duration).count();
+}
 
-    VkPipelineShaderStageCreateInfo shaderStages[2]{ 
+Pipeline::Pipeline(Device& device, VkPipeline pipeline, const PipelineTimings& timings)
+    : device(device), m_graphicsPipeline(pipeline), m_vertShaderModule(VK_NULL_HANDLE), m_fragShaderModule(VK_NULL_HANDLE), m_timings(timings)
+{
+}
+
+Pipeline::~Pipeline()
+{
+    vkDestroyShaderModule(device.device(), m_vertShaderModule, nullptr);
+    vkDestroyShaderModule(device.device(), m_fragShaderModule, nullptr);
+
+    vkDestroyPipeline(device.device(), m_graphicsPipeline, nullptr);
+}
+
+GraphicsPipelineState::GraphicsPipelineState(const PipelineConfigInfo& configInfo, VkShaderModule vertShaderModule, VkShaderModule fragShaderModule)
+{
+    assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "Cannot craete graphics pipeline: no pipelineLayout provided");
+    assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot craete graphics pipeline: no renderPass provided");
+
+    specializationInfo = VkSpecializationInfo{
+        .mapEntryCount = static_cast<uint32_t>(configInfo.specializationEntries.size()),
+        .pMapEntries = configInfo.specializationEntries.data(),
+        .dataSize = configInfo.specializationData.size() * sizeof(VkBool32),
+        .pData = configInfo.specializationData.data()
+    };
+    const VkSpecializationInfo* specialization{ configInfo.specializationEntries.empty() ? nullptr : &specializationInfo };
+
+    shaderStages = {
         VkPipelineShaderStageCreateInfo{
             .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
             .pNext = nullptr,
             .flags = 0,
             .stage = VK_SHADER_STAGE_VERTEX_BIT,
-            .module = m_vertShaderModule,
+            .module = vertShaderModule,
             .pName = "main",
-            .pSpecializationInfo = nullptr
+            .pSpecializationInfo = specialization
         },
         VkPipelineShaderStageCreateInfo{
             .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
             .pNext = nullptr,
             .flags = 0,
             .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-            .module = m_fragShaderModule,
+            .module = fragShaderModule,
             .pName = "main",
-            .pSpecializationInfo = nullptr
+            .pSpecializationInfo = specialization
         }
     };
 
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo{
+    vertexInputInfo = VkPipelineVertexInputStateCreateInfo{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        .vertexBindingDescriptionCount = 0,
-        .pVertexBindingDescriptions = nullptr,
-        .vertexAttributeDescriptionCount = 0,
-        .pVertexAttributeDescriptions = nullptr
+        .vertexBindingDescriptionCount = static_cast<uint32_t>(configInfo.bindingDescriptions.size()),
+        .pVertexBindingDescriptions = configInfo.bindingDescriptions.data(),
+        .vertexAttributeDescriptionCount = static_cast<uint32_t>(configInfo.attributeDescriptions.size()),
+        .pVertexAttributeDescriptions = configInfo.attributeDescriptions.data()
     };
 
-    VkPipelineViewportStateCreateInfo viewportInfo{
+    // dynamic, so one pipeline serves every extent
+    viewportInfo = VkPipelineViewportStateCreateInfo{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
         .viewportCount = 1,
-        .pViewports = &configInfo.viewport,
+        .pViewports = nullptr,
         .scissorCount = 1,
-        .pScissors = &configInfo.scissor
+        .pScissors = nullptr
     };
 
-    VkGraphicsPipelineCreateInfo pipelineInfo{
+    dynamicStateInfo = VkPipelineDynamicStateCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = static_cast<uint32_t>(DYNAMIC_STATES.size()),
+        .pDynamicStates = DYNAMIC_STATES.data()
+    };
+
+    // the config may have been copied, so the attachment pointer is taken from this copy
+    colorBlendInfo = configInfo.colorBlendInfo;
+    colorBlendInfo.pAttachments = &configInfo.colorBlendAttachment;
+
+    createInfo = VkGraphicsPipelineCreateInfo{
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-        .stageCount = 2,
-        .pStages = shaderStages,
+        .stageCount = static_cast<uint32_t>(shaderStages.size()),
+        .pStages = shaderStages.data(),
         .pVertexInputState = &vertexInputInfo,
         .pInputAssemblyState = &configInfo.inputAssemblyInfo,
         .pViewportState = &viewportInfo,
         .pRasterizationState = &configInfo.rasterizationInfo,
         .pMultisampleState = &configInfo.multisampleInfo,
         .pDepthStencilState = &configInfo.depthStencilInfo,
-        .pColorBlendState = &configInfo.colorBlendInfo,
-        .pDynamicState = nullptr,
+        .pColorBlendState = &colorBlendInfo,
+        .pDynamicState = &dynamicStateInfo,
         .layout = configInfo.pipelineLayout,
         .renderPass = configInfo.renderPass,
         .subpass = configInfo.subpass,
         .basePipelineHandle = VK_NULL_HANDLE,
         .basePipelineIndex = -1
     };
-
-    if(vkCreateGraphicsPipelines(device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS)
-        throw std::runtime_error("Failure while creating graphics pipeline");
 }
 
-Pipeline::~Pipeline()
-{
-    vkDestroyShaderModule(device.device(), m_vertShaderModule, nullptr);
-    vkDestroyShaderModule(device.device(), m_fragShaderModule, nullptr);
-
-    vkDestroyPipeline(device.device(), m_graphicsPipeline, nullptr);
-}
-
-PipelineConfigInfo Pipeline::defaultPipelineConfigInfo(uint32_t width, uint32_t height)
+PipelineConfigInfo Pipeline::defaultPipelineConfigInfo()
 {
     PipelineConfigInfo configInfo{
-        .viewport = VkViewport{
-            .x = 0.f,
-            .y = 0.f,
-            .width = static_cast<float>(width),
-            .height = static_cast<float>(height),
-            .minDepth = 0.f,
-            .maxDepth = 1.f
-        },
-        .scissor = VkRect2D{
-            .offset = { 0, 0 },
-            .extent = { width, height }
-        },
         .inputAssemblyInfo = VkPipelineInputAssemblyStateCreateInfo{
             .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
             .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
@@ -160,11 +189,62 @@ PipelineConfigInfo Pipeline::defaultPipelineConfigInfo(uint32_t width, uint32_t
     return configInfo;
 }
 
+PipelineConfigInfo Pipeline::variantPipelineConfigInfo(const PipelineVariant& variant)
+{
+    if(!variant.isValid())
+        throw std::runtime_error("Failure while configuring pipeline: invalid variant");
+
+    PipelineConfigInfo configInfo{ defaultPipelineConfigInfo() };
+    configInfo.inputAssemblyInfo.topology = variant.topology;
+    configInfo.rasterizationInfo.cullMode = variant.cullMode;
+    configInfo.depthStencilInfo.depthTestEnable = variant.depthTest ? VK_TRUE : VK_FALSE;
+    configInfo.depthStencilInfo.depthWriteEnable = variant.depthWrite ? VK_TRUE : VK_FALSE;
+
+    if(variant.blend)
+    {
+        configInfo.colorBlendAttachment.blendEnable = VK_TRUE;
+        configInfo.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        configInfo.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    }
+
+    // every feature is specialized, shaders that don't declare a constant_id ignore its entry
+    for(uint32_t feature{ 0 }; feature < PipelineVariant::FEATURE_COUNT; ++feature)
+    {
+        configInfo.specializationEntries.push_back(VkSpecializationMapEntry{
+            .constantID = feature,
+            .offset = static_cast<uint32_t>(feature * sizeof(VkBool32)),
+            .size = sizeof(VkBool32)
+        });
+        configInfo.specializationData.push_back(variant.has(static_cast<ShaderFeature>(feature)) ? VK_TRUE : VK_FALSE);
+    }
+
+    return configInfo;
+}
+
 void Pipeline::bind(VkCommandBuffer commandBuffer)
 {
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline);
 }
 
+void Pipeline::setViewport(VkCommandBuffer commandBuffer, VkExtent2D extent)
+{
+    VkViewport viewport{
+        .x = 0.f,
+        .y = 0.f,
+        .width = static_cast<float>(extent.width),
+        .height = static_cast<float>(extent.height),
+        .minDepth = 0.f,
+        .maxDepth = 1.f
+    };
+    VkRect2D scissor{
+        .offset = { 0, 0 },
+        .extent = extent
+    };
+
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
 std::vector<char> Pipeline::readFile(const std::filesystem::path& filepath)
 {
     std::ifstream file(filepath, std::ios::ate | std::ios::binary);
@@ -184,6 +264,11 @@ std::vector<char> Pipeline::readFile(const std::filesystem::path& filepath)
 }
 
 void Pipeline::createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule)
+{
+    *shaderModule = createShaderModule(device, code);
+}
+
+VkShaderModule Pipeline::createShaderModule(Device& device, const std::vector<char>& code)
 {
     VkShaderModuleCreateInfo createInfo{
         .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
@@ -191,6 +276,9 @@ void Pipeline::createShaderModule(const std::vector<char>& code, VkShaderModule*
         .pCode = reinterpret_cast<const uint32_t*>(code.data())
     };
 
-    if(vkCreateShaderModule(device.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
+    VkShaderModule shaderModule;
+    if(vkCreateShaderModule(device.device(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
         throw std::runtime_error("Failure while Creating shader module");
+
+    return shaderModule;
 }
@@ -2,16 +2,17 @@
 #define PIPELINE_HPP
 
 #include "Device.hpp"
+#include "PipelineVariant.hpp"
 
+#include <array>
 #include <filesystem>
 #include <string>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
+// viewport and scissor are dynamic and not part of the config, see Pipeline::setViewport
 struct PipelineConfigInfo
 {
-    VkViewport viewport;
-    VkRect2D scissor;
     VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
     VkPipelineRasterizationStateCreateInfo rasterizationInfo;
     VkPipelineMultisampleStateCreateInfo multisampleInfo;
@@ -21,28 +22,75 @@ struct PipelineConfigInfo
     VkPipelineLayout pipelineLayout{ nullptr };
     VkRenderPass renderPass{ nullptr };
     uint32_t subpass{ 0 };
+    // empty when the vertex shader generates its own vertices, see Model::vertexInputDescription
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+    // boolean specialization constants given to both stages, empty leaves the shader defaults
+    std::vector<VkSpecializationMapEntry> specializationEntries;
+    std::vector<VkBool32> specializationData;
+};
+
+struct PipelineTimings
+{
+    double shaderModulesMs{ 0.0 };
+    double createPipelineMs{ 0.0 };
+};
+
+// everything a VkGraphicsPipelineCreateInfo points to besides the config, which has to outlive it as well
+struct GraphicsPipelineState
+{
+    GraphicsPipelineState(const PipelineConfigInfo& configInfo, VkShaderModule vertShaderModule, VkShaderModule fragShaderModule);
+
+    GraphicsPipelineState(const GraphicsPipelineState&) = delete;
+    GraphicsPipelineState& operator=(const GraphicsPipelineState&) = delete;
+
+    static constexpr std::array<VkDynamicState, 2> DYNAMIC_STATES{ VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+    VkSpecializationInfo specializationInfo;
+    std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages;
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo;
+    VkPipelineViewportStateCreateInfo viewportInfo;
+    VkPipelineColorBlendStateCreateInfo colorBlendInfo;
+    VkPipelineDynamicStateCreateInfo dynamicStateInfo;
+    VkGraphicsPipelineCreateInfo createInfo;
 };
 
 class Pipeline
 {
 public:
     Pipeline(Device& device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
+    // takes ownership of a pipeline created elsewhere, see PipelineBuilder
+    Pipeline(Device& device, VkPipeline pipeline, const PipelineTimings& timings);
     ~Pipeline();
 
     Pipeline(const Pipeline&) = delete;
     void operator=(const Pipeline&) = delete;
 
-    static PipelineConfigInfo defaultPipelineConfigInfo(uint32_t width, uint32_t height);
+    static PipelineConfigInfo defaultPipelineConfigInfo();
+    static PipelineConfigInfo variantPipelineConfigInfo(const PipelineVariant& variant);
+
+    // rejects invalid variants at compile time
+    template<PipelineVariant Variant>
+    static PipelineConfigInfo variantPipelineConfigInfo()
+    {
+        static_assert(Variant.isValid(), "Invalid pipeline variant");
+        return variantPipelineConfigInfo(Variant);
+    }
 
     void bind(VkCommandBuffer commandBuffer);
+    // the dynamic state every pipeline expects, not inherited by secondary command buffers
+    static void setViewport(VkCommandBuffer commandBuffer, VkExtent2D extent);
+    const PipelineTimings& timings() const { return m_timings; }
+
+    static std::vector<char> readFile(const std::filesystem::path& filepath);
+    static VkShaderModule createShaderModule(Device& device, const std::vector<char>& code);
 
 private:
     Device& device;
     VkPipeline m_graphicsPipeline;
     VkShaderModule m_vertShaderModule;
     VkShaderModule m_fragShaderModule;
-
-    static std::vector<char> readFile(const std::filesystem::path& filepath);
+    PipelineTimings m_timings;
 
     void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
 };
@@ -0,0 +1,117 @@
+#include "PipelineBuilder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <map>
+#include <stdexcept>
+#include <utility>
+
+PipelineBuilder::PipelineBuilder(Device& device, uint32_t threadCount, uint32_t batchSize)
+    : device(device), m_batchSize(std::max(batchSize, 1u)), m_pool(threadCount)
+{
+}
+
+std::vector<std::future<std::shared_ptr<Pipeline>>> PipelineBuilder::build(std::vector<PipelineBuildRequest> requests)
+{
+    std::vector<std::future<std::shared_ptr<Pipeline>>> futures;
+    futures.reserve(requests.size());
+
+    // small request lists are spread over every worker rather than filling one batch
+    uint32_t workers{ std::max(m_pool.size(), 1u) };
+    size_t batchSize{ std::min<size_t>(m_batchSize, (requests.size() + workers - 1) / workers) };
+
+    for(size_t first{ 0 }; first < requests.size(); first += batchSize)
+    {
+        auto batch{ std::make_shared<Batch>() };
+        size_t last{ std::min(first + batchSize, requests.size()) };
+
+        for(size_t i{ first }; i < last; ++i)
+        {
+            batch->requests.push_back(std::move(requests[i]));
+            futures.push_back(batch->promises.emplace_back().get_future());
+        }
+
+        m_pool.submit([this, batch]() { buildBatch(*batch); });
+    }
+
+    return futures;
+}
+
+std::future<std::shared_ptr<Pipeline>> PipelineBuilder::build(PipelineBuildRequest request)
+{
+    std::vector<PipelineBuildRequest> requests;
+    requests.push_back(std::move(request));
+
+    return std::move(build(std::move(requests)).front());
+}
+
+void PipelineBuilder::buildBatch(Batch& batch)
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    uint32_t count{ static_cast<uint32_t>(batch.requests.size()) };
+    // keyed by file and by the bytes handed in, null when the file is read here
+    std::map<std::pair<std::string, const std::vector<char>*>, VkShaderModule> shaderModules;
+    std::vector<VkPipeline> pipelines(count, VK_NULL_HANDLE);
+    PipelineTimings timings;
+    std::exception_ptr error;
+
+    try
+    {
+        auto shaderModule{ [this, &shaderModules](const std::string& filepath, const std::shared_ptr<const std::vector<char>>& code) {
+            auto [it, inserted]{ shaderModules.try_emplace(std::pair{ filepath, code.get() }, VK_NULL_HANDLE) };
+            if(inserted)
+                it->second = Pipeline::createShaderModule(device, code ? *code : Pipeline::readFile(filepath));
+            return it->second;
+        } };
+
+        auto shaderStart{ std::chrono::steady_clock::now() };
+
+        // the create infos point into the states, which are kept apart so they never move
+        std::vector<std::unique_ptr<GraphicsPipelineState>> states;
+        std::vector<VkGraphicsPipelineCreateInfo> createInfos;
+        states.reserve(count);
+        createInfos.reserve(count);
+
+        for(const auto& request: batch.requests)
+        {
+            states.push_back(std::make_unique<GraphicsPipelineState>(request.configInfo, shaderModule(request.vertFilepath, request.vertCode), shaderModule(request.fragFilepath, request.fragCode)));
+            createInfos.push_back(states.back()->createInfo);
+        }
+
+        timings.shaderModulesMs = Milliseconds(std::chrono::steady_clock::now() - shaderStart).count() / count;
+
+        PipelineCache& pipelineCache{ device.pipelineCache() };
+        auto start{ std::chrono::steady_clock::now() };
+
+        VkResult result{ vkCreateGraphicsPipelines(device.device(), pipelineCache.handle(), count, createInfos.data(), nullptr, pipelines.data()) };
+
+        auto duration{ std::chrono::steady_clock::now() - start };
+        pipelineCache.recordCreation(duration, count);
+        timings.createPipelineMs = Milliseconds(duration).count() / count;
+
+        if(result != VK_SUCCESS)
+            throw std::runtime_error("Failure while creating graphics pipelines");
+    }
+    catch(...)
+    {
+        error = std::current_exception();
+    }
+
+    // the pipelines don't reference their modules after creation
+    for(auto [source, shaderModule]: shaderModules)
+        vkDestroyShaderModule(device.device(), shaderModule, nullptr);
+
+    for(uint32_t i{ 0 }; i < count; ++i)
+    {
+        if(error)
+        {
+            // a failed call may still have created some of the pipelines
+            vkDestroyPipeline(device.device(), pipelines[i], nullptr);
+            batch.promises[i].set_exception(error);
+        }
+        else
+            batch.promises[i].set_value(std::make_shared<Pipeline>(device, pipelines[i], timings));
+    }
+}
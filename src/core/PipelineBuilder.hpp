@@ -0,0 +1,58 @@
+#ifndef CORE_PIPELINE_BUILDER_HPP
+#define CORE_PIPELINE_BUILDER_HPP
+
+#include "Device.hpp"
+#include "Pipeline.hpp"
+#include "ThreadPool.hpp"
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct PipelineBuildRequest
+{
+    std::string vertFilepath;
+    std::string fragFilepath;
+    PipelineConfigInfo configInfo;
+    // compiled instead of the files when set, e.g. the exact bytes a cache key was hashed from
+    std::shared_ptr<const std::vector<char>> vertCode;
+    std::shared_ptr<const std::vector<char>> fragCode;
+};
+
+/*
+ * Builds graphics pipelines off the calling thread.
+ * Requests are split into batches, each batch is created by one vkCreateGraphicsPipelines call on a worker
+ * and every batch goes through the device's pipeline cache. Requests in a batch share the shader modules of the same file.
+ */
+class PipelineBuilder
+{
+public:
+    static constexpr uint32_t DEFAULT_BATCH_SIZE{ 16 };
+
+    // owns its workers, so a long build never holds up the recording threads
+    explicit PipelineBuilder(Device& device, uint32_t threadCount = ThreadPool::defaultThreadCount(), uint32_t batchSize = DEFAULT_BATCH_SIZE);
+
+    PipelineBuilder(const PipelineBuilder&) = delete;
+    PipelineBuilder& operator=(const PipelineBuilder&) = delete;
+
+    // futures are in request order, a failed batch fails every future in it
+    std::vector<std::future<std::shared_ptr<Pipeline>>> build(std::vector<PipelineBuildRequest> requests);
+    std::future<std::shared_ptr<Pipeline>> build(PipelineBuildRequest request);
+
+private:
+    struct Batch
+    {
+        std::vector<PipelineBuildRequest> requests;
+        std::vector<std::promise<std::shared_ptr<Pipeline>>> promises;
+    };
+
+    Device& device;
+    uint32_t m_batchSize;
+    ThreadPool m_pool;
+
+    void buildBatch(Batch& batch);
+};
+
+#endif //!CORE_PIPELINE_BUILDER_HPP
@@ -0,0 +1,161 @@
+#include "PipelineCache.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vulkan/vulkan_core.h>
+
+namespace
+{
+    // layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE, see the spec of vkGetPipelineCacheData
+    struct CacheHeader
+    {
+        uint32_t headerSize;
+        uint32_t headerVersion;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    };
+}
+
+PipelineCache::PipelineCache(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::filesystem::path& path)
+    : m_device(device), m_properties(properties), m_path(path)
+{
+    std::string rejectReason;
+    std::vector<char> blob{ loadBlob(rejectReason) };
+    m_warm = !blob.empty();
+
+    VkPipelineCacheCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = blob.size(),
+        .pInitialData = blob.empty() ? nullptr : blob.data()
+    };
+
+    if(vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_cache) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating pipeline cache");
+
+    if(m_warm)
+        std::clog << "pipeline cache: hit, loaded " << blob.size() << " bytes from " << m_path.string() << std::endl;
+    else
+        std::clog << "pipeline cache: miss, " << rejectReason << std::endl;
+}
+
+PipelineCache::~PipelineCache()
+{
+    std::clog << "pipeline cache: " << (m_warm ? "warm" : "cold") << " start, " << pipelineCount() << " pipelines created in " << creationMilliseconds() << " ms" << std::endl;
+
+    try
+    {
+        save();
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+    }
+
+    vkDestroyPipelineCache(m_device, m_cache, nullptr);
+}
+
+void PipelineCache::save()
+{
+    if(m_path.empty())
+        return;
+
+    size_t size{ 0 };
+    if(vkGetPipelineCacheData(m_device, m_cache, &size, nullptr) != VK_SUCCESS || size == 0)
+        return;
+
+    std::vector<char> blob(size);
+    if(vkGetPipelineCacheData(m_device, m_cache, &size, blob.data()) != VK_SUCCESS)
+        throw std::runtime_error("Failure while reading pipeline cache data");
+
+    std::filesystem::path tmpPath{ m_path };
+    tmpPath += ".tmp";
+
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if(!file.is_open())
+            throw std::runtime_error("Failure opening the file at: " + tmpPath.string());
+
+        file.write(blob.data(), static_cast<std::streamsize>(size));
+        file.flush();
+
+        if(!file.good())
+            throw std::runtime_error("Failure while writing the pipeline cache to: " + tmpPath.string());
+    }
+
+    std::filesystem::rename(tmpPath, m_path);
+}
+
+void PipelineCache::reset()
+{
+    VkPipelineCacheCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO
+    };
+
+    VkPipelineCache cache;
+    if(vkCreatePipelineCache(m_device, &createInfo, nullptr, &cache) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating pipeline cache");
+
+    vkDestroyPipelineCache(m_device, m_cache, nullptr);
+    m_cache = cache;
+    m_warm = false;
+    m_path.clear();
+}
+
+void PipelineCache::recordCreation(std::chrono::nanoseconds duration, uint32_t pipelineCount)
+{
+    m_pipelineCount += pipelineCount;
+    m_creationNanoseconds += duration.count();
+}
+
+std::vector<char> PipelineCache::loadBlob(std::string& rejectReason)
+{
+    if(m_path.empty())
+    {
+        rejectReason = "persistence disabled";
+        return {};
+    }
+
+    std::ifstream file(m_path, std::ios::ate | std::ios::binary);
+    if(!file.is_open())
+    {
+        rejectReason = "no cache at " + m_path.string();
+        return {};
+    }
+
+    size_t fileSize{ static_cast<size_t>(file.tellg()) };
+    std::vector<char> blob(fileSize);
+
+    file.seekg(0);
+    file.read(blob.data(), fileSize);
+
+    if(!isCompatible(blob, rejectReason))
+        return {};
+
+    return blob;
+}
+
+bool PipelineCache::isCompatible(const std::vector<char>& blob, std::string& rejectReason)
+{
+    CacheHeader header;
+    if(blob.size() < sizeof(header))
+    {
+        rejectReason = "cache file is truncated";
+        return false;
+    }
+
+    std::memcpy(&header, blob.data(), sizeof(header));
+
+    if(header.headerSize < sizeof(header) || header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+        rejectReason = "unknown cache header";
+    else if(header.vendorID != m_properties.vendorID || header.deviceID != m_properties.deviceID)
+        rejectReason = "cache was written for a different device";
+    else if(std::memcmp(header.pipelineCacheUUID, m_properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        rejectReason = "cache was written by a different driver version";
+    else
+        return true;
+
+    return false;
+}
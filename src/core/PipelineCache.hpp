@@ -0,0 +1,54 @@
+#ifndef CORE_PIPELINE_CACHE_HPP
+#define CORE_PIPELINE_CACHE_HPP
+
+#include <vulkan/vulkan_core.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/*
+ * VkPipelineCache that survives restarts.
+ * The blob from the last run is only handed to the driver when its header matches the current device,
+ * on shutdown the cache is written back through a temporary file and a rename so a crash never leaves a torn file.
+ * An empty path keeps the cache in memory only.
+ */
+class PipelineCache
+{
+public:
+    PipelineCache(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::filesystem::path& path);
+    ~PipelineCache();
+
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    VkPipelineCache handle() { return m_cache; }
+
+    void save();
+    // starts over with an empty cache that is no longer written back, so later creations time cache misses
+    // nothing may be creating pipelines through the cache meanwhile
+    void reset();
+    void recordCreation(std::chrono::nanoseconds duration, uint32_t pipelineCount = 1);
+
+    bool isWarm() const { return m_warm; }
+    uint32_t pipelineCount() const { return m_pipelineCount.load(); }
+    double creationMilliseconds() const { return static_cast<double>(m_creationNanoseconds.load()) / 1'000'000.0; }
+
+private:
+    VkDevice m_device;
+    VkPipelineCache m_cache;
+    VkPhysicalDeviceProperties m_properties;
+    std::filesystem::path m_path;
+
+    bool m_warm{ false };
+    std::atomic<uint32_t> m_pipelineCount{ 0 };
+    std::atomic<int64_t> m_creationNanoseconds{ 0 };
+
+    std::vector<char> loadBlob(std::string& rejectReason);
+    bool isCompatible(const std::vector<char>& blob, std::string& rejectReason);
+};
+
+#endif //!CORE_PIPELINE_CACHE_HPP
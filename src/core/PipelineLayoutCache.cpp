@@ -0,0 +1,52 @@
+#include "PipelineLayoutCache.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+PipelineLayoutCache::PipelineLayoutCache(VkDevice device, DescriptorLayoutCache& descriptorLayouts)
+    : m_device(device), m_descriptorLayouts(descriptorLayouts)
+{
+}
+
+PipelineLayoutCache::~PipelineLayoutCache()
+{
+    for(auto& [key, layout]: m_layouts)
+        vkDestroyPipelineLayout(m_device, layout, nullptr);
+}
+
+PipelineLayoutCache::Layout PipelineLayoutCache::get(const ShaderReflection& reflection)
+{
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    for(uint32_t set{ 0 }; set < reflection.setCount(); ++set)
+        setLayouts.push_back(m_descriptorLayouts.get(reflection.setBindings(set)));
+
+    return get(setLayouts, reflection.pushConstants);
+}
+
+PipelineLayoutCache::Layout PipelineLayoutCache::get(const std::vector<VkDescriptorSetLayout>& setLayouts, const VkPushConstantRange& pushConstants)
+{
+    // without push constants the stages don't matter
+    VkPushConstantRange range{ pushConstants.size > 0 ? pushConstants : VkPushConstantRange{ 0, 0, 0 } };
+    LayoutKey key{ setLayouts, range.stageFlags, range.offset, range.size };
+
+    std::lock_guard<std::mutex> lock{ m_mutex };
+
+    auto it{ m_layouts.find(key) };
+    if(it != m_layouts.end())
+        return Layout{ it->second, setLayouts, range };
+
+    VkPipelineLayoutCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
+        .pSetLayouts = setLayouts.data(),
+        .pushConstantRangeCount = range.size > 0 ? 1u : 0u,
+        .pPushConstantRanges = range.size > 0 ? &range : nullptr
+    };
+
+    VkPipelineLayout layout;
+    if(vkCreatePipelineLayout(m_device, &createInfo, nullptr, &layout) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating pipeline layout");
+
+    m_layouts.emplace(std::move(key), layout);
+    return Layout{ layout, setLayouts, range };
+}
@@ -0,0 +1,53 @@
+#ifndef CORE_PIPELINE_LAYOUT_CACHE_HPP
+#define CORE_PIPELINE_LAYOUT_CACHE_HPP
+
+#include "DescriptorLayoutCache.hpp"
+#include "ShaderReflection.hpp"
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+/*
+ * Owns every VkPipelineLayout, keyed by its set layouts and push constant range.
+ * Set layouts come from the DescriptorLayoutCache, so pipelines whose shaders declare the same interface share one
+ * layout handle and stay compatible for descriptor sets and push constants bound across pipeline switches.
+ */
+class PipelineLayoutCache
+{
+public:
+    struct Layout
+    {
+        VkPipelineLayout handle;
+        // one per set index, sets are allocated with these
+        std::vector<VkDescriptorSetLayout> setLayouts;
+        VkPushConstantRange pushConstants;
+    };
+
+    PipelineLayoutCache(VkDevice device, DescriptorLayoutCache& descriptorLayouts);
+    ~PipelineLayoutCache();
+
+    PipelineLayoutCache(const PipelineLayoutCache&) = delete;
+    PipelineLayoutCache& operator=(const PipelineLayoutCache&) = delete;
+
+    // the returned layout lives as long as the cache
+    Layout get(const ShaderReflection& reflection);
+    Layout get(const std::vector<VkDescriptorSetLayout>& setLayouts, const VkPushConstantRange& pushConstants);
+
+    size_t size() const { return m_layouts.size(); }
+
+private:
+    // set layouts, push constant stages, offset, size
+    using LayoutKey = std::tuple<std::vector<VkDescriptorSetLayout>, VkShaderStageFlags, uint32_t, uint32_t>;
+
+    VkDevice m_device;
+    DescriptorLayoutCache& m_descriptorLayouts;
+    std::map<LayoutKey, VkPipelineLayout> m_layouts;
+    std::mutex m_mutex;
+};
+
+#endif //!CORE_PIPELINE_LAYOUT_CACHE_HPP
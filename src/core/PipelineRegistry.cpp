@@ -0,0 +1,260 @@
+#include "PipelineRegistry.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    // FNV-1a, fed field by field so padding and pNext pointers never reach the key
+    struct Hasher
+    {
+        uint64_t value{ 14695981039346656037ull };
+
+        void bytes(const void* data, size_t size)
+        {
+            const auto* byte{ static_cast<const unsigned char*>(data) };
+            for(size_t i{ 0 }; i < size; ++i)
+            {
+                value ^= byte[i];
+                value *= 1099511628211ull;
+            }
+        }
+
+        template<typename T>
+        void add(const T& field)
+        {
+            bytes(&field, sizeof(field));
+        }
+    };
+}
+
+PipelineRegistry::PipelineRegistry(PipelineBuilder& builder)
+    : m_builder(builder)
+{
+}
+
+std::vector<PipelineRegistry::PipelineFuture> PipelineRegistry::acquire(std::vector<PipelineBuildRequest> requests)
+{
+    std::vector<uint64_t> keys;
+    std::vector<PipelineBuildRequest> misses;
+    std::vector<uint64_t> missKeys;
+
+    // every key first, a missing shader file throws before the registry is touched
+    keys.reserve(requests.size());
+    for(auto& request: requests)
+        keys.push_back(key(request));
+
+    // touched before trimming, so a pipeline asked for again is not evicted right before it would hit
+    ++m_acquireCount;
+    for(uint64_t requestKey: keys)
+    {
+        if(auto entry{ m_entries.find(requestKey) }; entry != m_entries.end())
+            entry->second.lastUse = m_acquireCount;
+    }
+
+    // a build that failed since the last call is retried below instead of handing out its exception again
+    trim();
+
+    for(size_t i{ 0 }; i < requests.size(); ++i)
+    {
+        PipelineBuildRequest& request{ requests[i] };
+        uint64_t requestKey{ keys[i] };
+
+        // a duplicate later in this call finds the entry of the first one before it is built
+        auto [entry, inserted]{ m_entries.try_emplace(requestKey, Entry{ .renderPass = request.configInfo.renderPass, .future = {} }) };
+        entry->second.lastUse = m_acquireCount;
+        if(!inserted)
+        {
+            ++m_hits;
+            continue;
+        }
+
+        ++m_misses;
+        missKeys.push_back(requestKey);
+        misses.push_back(std::move(request));
+    }
+
+    auto built{ m_builder.build(std::move(misses)) };
+    for(size_t i{ 0 }; i < built.size(); ++i)
+        m_entries[missKeys[i]].future = built[i].share();
+
+    std::vector<PipelineFuture> futures;
+    futures.reserve(keys.size());
+    for(uint64_t requestKey: keys)
+        futures.push_back(m_entries[requestKey].future);
+
+    return futures;
+}
+
+PipelineRegistry::PipelineFuture PipelineRegistry::acquire(PipelineBuildRequest request)
+{
+    std::vector<PipelineBuildRequest> requests;
+    requests.push_back(std::move(request));
+
+    return acquire(std::move(requests)).front();
+}
+
+void PipelineRegistry::evictRenderPass(VkRenderPass renderPass)
+{
+    // pipelines still drawn with are kept alive by their other owners
+    std::erase_if(m_entries, [renderPass](const auto& entry) { return entry.second.renderPass == renderPass; });
+}
+
+void PipelineRegistry::trim()
+{
+    std::vector<std::pair<uint64_t, uint64_t>> unused;
+
+    for(auto it{ m_entries.begin() }; it != m_entries.end();)
+    {
+        PipelineFuture& future{ it->second.future };
+        if(!future.valid() || future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++it;
+            continue;
+        }
+
+        try
+        {
+            // the future's shared state holds one reference, callers that took the pipeline hold the others
+            if(future.get().use_count() == 1)
+                unused.emplace_back(it->second.lastUse, it->first);
+            ++it;
+        }
+        catch(...)
+        {
+            it = m_entries.erase(it);
+        }
+    }
+
+    if(unused.size() <= MAX_UNUSED_ENTRIES)
+        return;
+
+    // oldest first, the newest MAX_UNUSED_ENTRIES survive
+    std::sort(unused.begin(), unused.end());
+    for(size_t i{ 0 }; i < unused.size() - MAX_UNUSED_ENTRIES; ++i)
+        m_entries.erase(unused[i].second);
+}
+
+void PipelineRegistry::waitIdle()
+{
+    for(auto& entry: m_entries)
+        entry.second.future.wait();
+}
+
+uint64_t PipelineRegistry::hash(const PipelineConfigInfo& configInfo)
+{
+    Hasher hasher;
+
+    const auto& inputAssembly{ configInfo.inputAssemblyInfo };
+    hasher.add(inputAssembly.topology);
+    hasher.add(inputAssembly.primitiveRestartEnable);
+
+    const auto& rasterization{ configInfo.rasterizationInfo };
+    hasher.add(rasterization.depthClampEnable);
+    hasher.add(rasterization.rasterizerDiscardEnable);
+    hasher.add(rasterization.polygonMode);
+    hasher.add(rasterization.cullMode);
+    hasher.add(rasterization.frontFace);
+    hasher.add(rasterization.depthBiasEnable);
+    hasher.add(rasterization.depthBiasConstantFactor);
+    hasher.add(rasterization.depthBiasClamp);
+    hasher.add(rasterization.depthBiasSlopeFactor);
+    hasher.add(rasterization.lineWidth);
+
+    const auto& multisample{ configInfo.multisampleInfo };
+    hasher.add(multisample.rasterizationSamples);
+    hasher.add(multisample.sampleShadingEnable);
+    hasher.add(multisample.minSampleShading);
+    hasher.add(multisample.alphaToCoverageEnable);
+    hasher.add(multisample.alphaToOneEnable);
+
+    const auto& attachment{ configInfo.colorBlendAttachment };
+    hasher.add(attachment.blendEnable);
+    hasher.add(attachment.srcColorBlendFactor);
+    hasher.add(attachment.dstColorBlendFactor);
+    hasher.add(attachment.colorBlendOp);
+    hasher.add(attachment.srcAlphaBlendFactor);
+    hasher.add(attachment.dstAlphaBlendFactor);
+    hasher.add(attachment.alphaBlendOp);
+    hasher.add(attachment.colorWriteMask);
+
+    const auto& colorBlend{ configInfo.colorBlendInfo };
+    hasher.add(colorBlend.logicOpEnable);
+    hasher.add(colorBlend.logicOp);
+    hasher.add(colorBlend.attachmentCount);
+    hasher.add(colorBlend.blendConstants);
+
+    const auto& depthStencil{ configInfo.depthStencilInfo };
+    hasher.add(depthStencil.depthTestEnable);
+    hasher.add(depthStencil.depthWriteEnable);
+    hasher.add(depthStencil.depthCompareOp);
+    hasher.add(depthStencil.depthBoundsTestEnable);
+    hasher.add(depthStencil.stencilTestEnable);
+    hasher.add(depthStencil.minDepthBounds);
+    hasher.add(depthStencil.maxDepthBounds);
+
+    hasher.add(configInfo.pipelineLayout);
+    hasher.add(configInfo.renderPass);
+    hasher.add(configInfo.subpass);
+
+    for(const auto& binding: configInfo.bindingDescriptions)
+    {
+        hasher.add(binding.binding);
+        hasher.add(binding.stride);
+        hasher.add(binding.inputRate);
+    }
+
+    // counts separate the lists, otherwise moving an element from one list to the next keeps the key
+    hasher.add(configInfo.bindingDescriptions.size());
+    for(const auto& attribute: configInfo.attributeDescriptions)
+    {
+        hasher.add(attribute.location);
+        hasher.add(attribute.binding);
+        hasher.add(attribute.format);
+        hasher.add(attribute.offset);
+    }
+
+    hasher.add(configInfo.attributeDescriptions.size());
+    for(const auto& entry: configInfo.specializationEntries)
+    {
+        hasher.add(entry.constantID);
+        hasher.add(entry.offset);
+        hasher.add(entry.size);
+    }
+
+    hasher.add(configInfo.specializationEntries.size());
+    for(VkBool32 value: configInfo.specializationData)
+        hasher.add(value);
+
+    return hasher.value;
+}
+
+uint64_t PipelineRegistry::key(PipelineBuildRequest& request)
+{
+    const ShaderCode& vert{ shaderCode(request.vertFilepath) };
+    const ShaderCode& frag{ shaderCode(request.fragFilepath) };
+    request.vertCode = vert.code;
+    request.fragCode = frag.code;
+
+    Hasher hasher;
+    hasher.add(hash(request.configInfo));
+    hasher.add(vert.hash);
+    hasher.add(frag.hash);
+
+    return hasher.value;
+}
+
+const PipelineRegistry::ShaderCode& PipelineRegistry::shaderCode(const std::string& filepath)
+{
+    auto lastWrite{ std::filesystem::last_write_time(filepath) };
+
+    auto it{ m_shaderCode.find(filepath) };
+    if(it != m_shaderCode.end() && it->second.lastWrite == lastWrite)
+        return it->second;
+
+    auto code{ std::make_shared<const std::vector<char>>(Pipeline::readFile(filepath)) };
+    Hasher hasher;
+    hasher.bytes(code->data(), code->size());
+
+    return m_shaderCode[filepath] = ShaderCode{ .lastWrite = lastWrite, .code = std::move(code), .hash = hasher.value };
+}
@@ -0,0 +1,83 @@
+#ifndef CORE_PIPELINE_REGISTRY_HPP
+#define CORE_PIPELINE_REGISTRY_HPP
+
+#include "Pipeline.hpp"
+#include "PipelineBuilder.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Deduplicates graphics pipelines.
+ * Requests are keyed on a hash of their config and of the SPIR-V content of their shaders, an identical request
+ * gets the pipeline built, or still building, for the first one. Editing a shader changes the key and reverting it hits again.
+ * The builder compiles the bytes that were hashed, a shader rewritten in between can't end up under the old key.
+ * Handles in the config are part of the key, so entries for a destroyed render pass have to be evicted.
+ * Failed builds are forgotten so the next request retries, and only the MAX_UNUSED_ENTRIES most recently requested
+ * pipelines nobody else holds are kept around for a revert.
+ * Only used from one thread.
+ */
+class PipelineRegistry
+{
+public:
+    using PipelineFuture = std::shared_future<std::shared_ptr<Pipeline>>;
+
+    static constexpr size_t MAX_UNUSED_ENTRIES{ 16 };
+
+    explicit PipelineRegistry(PipelineBuilder& builder);
+
+    PipelineRegistry(const PipelineRegistry&) = delete;
+    PipelineRegistry& operator=(const PipelineRegistry&) = delete;
+
+    // the misses of one call go to the builder together, so they are batched
+    std::vector<PipelineFuture> acquire(std::vector<PipelineBuildRequest> requests);
+    PipelineFuture acquire(PipelineBuildRequest request);
+
+    void evictRenderPass(VkRenderPass renderPass);
+    // blocks until every pipeline still building is done, before destroying what their configs reference
+    void waitIdle();
+
+    uint64_t hits() const { return m_hits; }
+    uint64_t misses() const { return m_misses; }
+    size_t size() const { return m_entries.size(); }
+
+    static uint64_t hash(const PipelineConfigInfo& configInfo);
+
+private:
+    struct Entry
+    {
+        VkRenderPass renderPass;
+        PipelineFuture future;
+        // acquire call that last asked for it
+        uint64_t lastUse{ 0 };
+    };
+
+    // content of the shader files and its hash, only reread once the file was written again
+    struct ShaderCode
+    {
+        std::filesystem::file_time_type lastWrite;
+        std::shared_ptr<const std::vector<char>> code;
+        uint64_t hash;
+    };
+
+    PipelineBuilder& m_builder;
+    std::unordered_map<uint64_t, Entry> m_entries;
+    std::unordered_map<std::string, ShaderCode> m_shaderCode;
+    uint64_t m_hits{ 0 };
+    uint64_t m_misses{ 0 };
+    uint64_t m_acquireCount{ 0 };
+
+    // also hands the hashed SPIR-V to the request
+    uint64_t key(PipelineBuildRequest& request);
+    const ShaderCode& shaderCode(const std::string& filepath);
+    // drops failed builds and the least recently requested pipelines beyond MAX_UNUSED_ENTRIES that only the registry holds
+    void trim();
+};
+
+#endif //!CORE_PIPELINE_REGISTRY_HPP
@@ -0,0 +1,127 @@
+#ifndef CORE_PIPELINE_VARIANT_HPP
+#define CORE_PIPELINE_VARIANT_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vulkan/vulkan_core.h>
+
+// shader toggles, the value is both the bit in PipelineVariant::features and the constant_id in the shaders
+enum class ShaderFeature : uint32_t
+{
+    VertexColor = 0,
+    Grayscale = 1,
+    Count
+};
+
+/*
+ * A pipeline permutation: the fixed function state that differs between pipelines plus the shader features,
+ * which are passed as boolean specialization constants so the driver folds the branches away.
+ * Variants are literal types, so they are validated and hashed at compile time and can be template arguments.
+ * Every variant is built from the same SPIR-V.
+ */
+struct PipelineVariant
+{
+    static constexpr uint32_t FEATURE_COUNT{ static_cast<uint32_t>(ShaderFeature::Count) };
+
+    VkPrimitiveTopology topology{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST };
+    VkCullModeFlags cullMode{ VK_CULL_MODE_NONE };
+    bool depthTest{ true };
+    bool depthWrite{ true };
+    bool blend{ false };
+    uint32_t features{ 1u << static_cast<uint32_t>(ShaderFeature::VertexColor) };
+
+    constexpr bool has(ShaderFeature feature) const { return (features >> static_cast<uint32_t>(feature)) & 1u; }
+
+    constexpr PipelineVariant with(ShaderFeature feature, bool enabled = true) const
+    {
+        PipelineVariant variant{ *this };
+        uint32_t bit{ 1u << static_cast<uint32_t>(feature) };
+        variant.features = enabled ? (features | bit) : (features & ~bit);
+        return variant;
+    }
+
+    constexpr bool isValid() const
+    {
+        // depth writes are ignored without the test, blended geometry writing depth hides what is drawn behind it later
+        return features < (1u << FEATURE_COUNT) && (depthTest || !depthWrite) && !(blend && depthWrite);
+    }
+
+    // FNV-1a over the fields, stable across runs so it can key caches
+    constexpr uint64_t hash() const
+    {
+        uint64_t hash{ 14695981039346656037ull };
+        auto mix{ [&hash](uint32_t value) {
+            for(uint32_t i{ 0 }; i < 4; ++i)
+            {
+                hash ^= (value >> (i * 8)) & 0xffu;
+                hash *= 1099511628211ull;
+            }
+        } };
+
+        mix(static_cast<uint32_t>(topology));
+        mix(cullMode);
+        mix(static_cast<uint32_t>(depthTest) | static_cast<uint32_t>(depthWrite) << 1 | static_cast<uint32_t>(blend) << 2);
+        mix(features);
+        return hash;
+    }
+
+    constexpr bool operator==(const PipelineVariant&) const = default;
+};
+
+namespace PipelineVariants
+{
+    constexpr PipelineVariant Opaque{};
+    constexpr PipelineVariant Culled{ .cullMode = VK_CULL_MODE_BACK_BIT };
+    constexpr PipelineVariant Grayscale{ Opaque.with(ShaderFeature::Grayscale) };
+    constexpr PipelineVariant Unlit{ Opaque.with(ShaderFeature::VertexColor, false) };
+
+    struct Named
+    {
+        std::string_view name;
+        PipelineVariant variant;
+    };
+
+    constexpr std::array ALL{
+        Named{ "opaque", Opaque },
+        Named{ "culled", Culled },
+        Named{ "grayscale", Grayscale },
+        Named{ "unlit", Unlit }
+    };
+
+    constexpr std::optional<PipelineVariant> find(std::string_view name)
+    {
+        for(const auto& named: ALL)
+        {
+            if(named.name == name)
+                return named.variant;
+        }
+        return std::nullopt;
+    }
+
+    constexpr bool hashesAreUnique()
+    {
+        for(size_t i{ 0 }; i < ALL.size(); ++i)
+        {
+            for(size_t j{ i + 1 }; j < ALL.size(); ++j)
+            {
+                if(ALL[i].variant.hash() == ALL[j].variant.hash())
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(hashesAreUnique(), "Pipeline variants collide on their hash");
+    static_assert([] {
+        for(const auto& named: ALL)
+        {
+            if(!named.variant.isValid())
+                return false;
+        }
+        return true;
+    }(), "Invalid pipeline variant");
+}
+
+#endif //!CORE_PIPELINE_VARIANT_HPP
@@ -0,0 +1,592 @@
+#include "RenderGraph.hpp"
+#include "Device.hpp"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+namespace
+{
+    bool isDepthFormat(VkFormat format)
+    {
+        switch(format)
+        {
+            case VK_FORMAT_D16_UNORM:
+            case VK_FORMAT_X8_D24_UNORM_PACK32:
+            case VK_FORMAT_D32_SFLOAT:
+            case VK_FORMAT_D16_UNORM_S8_UINT:
+            case VK_FORMAT_D24_UNORM_S8_UINT:
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // where the final layout is consumed after the render pass
+    void finalStage(VkImageLayout layout, VkPipelineStageFlags& stage, VkAccessFlags& access)
+    {
+        switch(layout)
+        {
+            case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+                // the present waits on a semaphore, which already makes the writes available
+                stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+                access = 0;
+                break;
+            case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+                stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+                access = VK_ACCESS_TRANSFER_READ_BIT;
+                break;
+            case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+                stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                access = VK_ACCESS_SHADER_READ_BIT;
+                break;
+            default:
+                stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+                access = VK_ACCESS_MEMORY_READ_BIT;
+                break;
+        }
+    }
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeColor(RenderResource resource)
+{
+    m_graph.addUse(m_pass, resource, Access::ColorWrite);
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::writeDepth(RenderResource resource)
+{
+    m_graph.addUse(m_pass, resource, Access::DepthWrite);
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::readDepth(RenderResource resource)
+{
+    m_graph.addUse(m_pass, resource, Access::DepthRead);
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::readInput(RenderResource resource)
+{
+    m_graph.addUse(m_pass, resource, Access::InputRead);
+    return *this;
+}
+
+RenderResource RenderGraph::importAttachment(std::string name, VkFormat format, VkImageLayout finalLayout, std::optional<VkClearValue> clear)
+{
+    m_resources.push_back(Resource{ .name = std::move(name), .format = format, .imported = true, .finalLayout = finalLayout, .clear = clear });
+    return static_cast<RenderResource>(m_resources.size() - 1);
+}
+
+RenderResource RenderGraph::createAttachment(std::string name, VkFormat format, std::optional<VkClearValue> clear)
+{
+    m_resources.push_back(Resource{ .name = std::move(name), .format = format, .imported = false, .finalLayout = VK_IMAGE_LAYOUT_UNDEFINED, .clear = clear });
+    return static_cast<RenderResource>(m_resources.size() - 1);
+}
+
+RenderGraph::PassBuilder RenderGraph::addPass(std::string name)
+{
+    m_passes.push_back(Pass{ .name = std::move(name) });
+    return PassBuilder{ *this, static_cast<uint32_t>(m_passes.size() - 1) };
+}
+
+void RenderGraph::addUse(uint32_t pass, RenderResource resource, Access access)
+{
+    if(resource >= m_resources.size())
+        throw std::runtime_error("Failure while declaring render pass " + m_passes[pass].name + ": unknown attachment");
+
+    const Resource& declared{ m_resources[resource] };
+    bool depth{ isDepthFormat(declared.format) };
+    if(depth != (access == Access::DepthWrite || access == Access::DepthRead) && access != Access::InputRead)
+        throw std::runtime_error("Failure while declaring render pass " + m_passes[pass].name + ": " + declared.name + " has the wrong format for its use");
+
+    for(const Use& use: m_passes[pass].uses)
+    {
+        if(use.resource == resource)
+            throw std::runtime_error("Failure while declaring render pass " + m_passes[pass].name + ": " + declared.name + " is used twice");
+
+        bool depthUse{ use.access == Access::DepthWrite || use.access == Access::DepthRead };
+        if(depthUse && (access == Access::DepthWrite || access == Access::DepthRead))
+            throw std::runtime_error("Failure while declaring render pass " + m_passes[pass].name + ": a pass has at most one depth attachment");
+    }
+
+    m_passes[pass].uses.push_back(Use{ .resource = resource, .access = access });
+}
+
+void RenderGraph::cullPasses()
+{
+    // walking backwards from the imported attachments, a pass survives when something later needs what it writes
+    std::vector<bool> needed(m_resources.size(), false);
+    for(size_t i{ 0 }; i < m_resources.size(); ++i)
+        needed[i] = m_resources[i].imported;
+
+    std::vector<bool> live(m_passes.size(), false);
+    for(size_t i{ m_passes.size() }; i-- > 0;)
+    {
+        for(const Use& use: m_passes[i].uses)
+        {
+            if((use.access == Access::ColorWrite || use.access == Access::DepthWrite) && needed[use.resource])
+                live[i] = true;
+        }
+
+        // a write keeps what earlier passes wrote unless it is the first one, so everything a live pass touches is needed
+        if(live[i])
+        {
+            for(const Use& use: m_passes[i].uses)
+                needed[use.resource] = true;
+        }
+    }
+
+    uint32_t subpass{ 0 };
+    for(size_t i{ 0 }; i < m_passes.size(); ++i)
+        m_passes[i].subpass = live[i] ? std::optional<uint32_t>{ subpass++ } : std::nullopt;
+
+    if(subpass == 0)
+        throw std::runtime_error("Failure while compiling render graph: no pass writes an imported attachment");
+}
+
+std::vector<std::pair<RenderResource, RenderResource>> RenderGraph::assignAliasGroups()
+{
+    std::vector<RenderResource> order{ m_transients };
+    std::stable_sort(order.begin(), order.end(), [this](RenderResource a, RenderResource b) { return m_resources[a].firstSubpass < m_resources[b].firstSubpass; });
+
+    // interval colouring, each group remembers its current occupant
+    std::vector<RenderResource> occupants;
+    std::vector<std::pair<RenderResource, RenderResource>> handoffs;
+
+    for(RenderResource resource: order)
+    {
+        Resource& transient{ m_resources[resource] };
+        auto group{ std::find_if(occupants.begin(), occupants.end(), [&](RenderResource occupant) { return m_resources[occupant].lastSubpass < transient.firstSubpass; }) };
+
+        if(group == occupants.end())
+        {
+            transient.aliasGroup = static_cast<uint32_t>(occupants.size());
+            occupants.push_back(resource);
+            continue;
+        }
+
+        transient.aliasGroup = static_cast<uint32_t>(group - occupants.begin());
+        handoffs.emplace_back(*group, resource);
+        *group = resource;
+    }
+
+    m_aliasGroupCount = static_cast<uint32_t>(occupants.size());
+    return handoffs;
+}
+
+VkRenderPass RenderGraph::compile(VkDevice device)
+{
+    auto layoutFor{ [this](const Use& use) {
+        switch(use.access)
+        {
+            case Access::ColorWrite: return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            case Access::DepthWrite: return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            case Access::DepthRead: return VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+            default: return isDepthFormat(m_resources[use.resource].format) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        }
+    } };
+
+    auto stageFor{ [](Access access) -> VkPipelineStageFlags {
+        switch(access)
+        {
+            case Access::ColorWrite: return VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            case Access::InputRead: return VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            default: return VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        }
+    } };
+
+    auto accessFor{ [](Access access) -> VkAccessFlags {
+        switch(access)
+        {
+            case Access::ColorWrite: return VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            case Access::DepthWrite: return VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            case Access::DepthRead: return VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+            default: return VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+        }
+    } };
+
+    cullPasses();
+
+    for(auto& resource: m_resources)
+    {
+        resource.attachment.reset();
+        resource.aliasGroup.reset();
+        resource.usage = 0;
+    }
+
+    // lifetimes in subpasses, a read has to see a write of an earlier surviving pass
+    for(const auto& pass: m_passes)
+    {
+        if(!pass.subpass)
+            continue;
+
+        for(const Use& use: pass.uses)
+        {
+            Resource& resource{ m_resources[use.resource] };
+            bool write{ use.access == Access::ColorWrite || use.access == Access::DepthWrite };
+
+            if(!resource.attachment)
+            {
+                if(!write)
+                    throw std::runtime_error("Failure while compiling render graph: pass " + pass.name + " reads " + resource.name + " before any pass writes it");
+
+                resource.attachment = 0;
+                resource.firstSubpass = *pass.subpass;
+                resource.firstAccess = use.access;
+            }
+
+            resource.lastSubpass = *pass.subpass;
+            resource.lastAccess = use.access;
+
+            if(use.access == Access::ColorWrite)
+                resource.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+            else if(use.access == Access::InputRead)
+                resource.usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+            else
+                resource.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        }
+    }
+
+    // attachments in declaration order, attachments no surviving pass uses are dropped
+    m_clearValues.clear();
+    m_transients.clear();
+    m_imports.clear();
+    for(RenderResource i{ 0 }; i < m_resources.size(); ++i)
+    {
+        Resource& resource{ m_resources[i] };
+        if(resource.imported)
+            m_imports.push_back(i);
+
+        if(!resource.attachment)
+            continue;
+
+        resource.attachment = static_cast<uint32_t>(m_clearValues.size());
+        m_clearValues.push_back(resource.clear.value_or(VkClearValue{}));
+
+        if(!resource.imported)
+        {
+            resource.transientIndex = static_cast<uint32_t>(m_transients.size());
+            m_transients.push_back(i);
+        }
+    }
+
+    std::vector<std::pair<RenderResource, RenderResource>> handoffs{ assignAliasGroups() };
+    std::vector<uint32_t> groupSizes(m_aliasGroupCount, 0);
+    for(RenderResource transient: m_transients)
+        ++groupSizes[*m_resources[transient].aliasGroup];
+
+    std::vector<VkAttachmentDescription> attachments;
+    for(RenderResource i{ 0 }; i < m_resources.size(); ++i)
+    {
+        const Resource& resource{ m_resources[i] };
+        if(!resource.attachment)
+            continue;
+
+        bool aliased{ resource.aliasGroup && groupSizes[*resource.aliasGroup] > 1 };
+        attachments.push_back(VkAttachmentDescription{
+            .flags = aliased ? VK_ATTACHMENT_DESCRIPTION_MAY_ALIAS_BIT : VkAttachmentDescriptionFlags{ 0 },
+            .format = resource.format,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            // nothing before the render pass is ever kept, the first use clears or overwrites
+            .loadOp = resource.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .storeOp = resource.imported ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            // a transient stays in the layout of its last use, no transition nobody would look at
+            .finalLayout = resource.imported ? resource.finalLayout : layoutFor(Use{ .resource = i, .access = resource.lastAccess })
+        });
+    }
+
+    uint32_t subpassCount{ 0 };
+    for(const auto& pass: m_passes)
+        subpassCount += pass.subpass ? 1 : 0;
+
+    // the references have to outlive vkCreateRenderPass
+    std::vector<std::vector<VkAttachmentReference>> colorRefs(subpassCount), inputRefs(subpassCount);
+    std::vector<VkAttachmentReference> depthRefs(subpassCount);
+    std::vector<std::vector<uint32_t>> preserved(subpassCount);
+    std::vector<VkSubpassDescription> subpasses(subpassCount);
+
+    for(const auto& pass: m_passes)
+    {
+        if(!pass.subpass)
+            continue;
+
+        uint32_t s{ *pass.subpass };
+        bool hasDepth{ false };
+
+        for(const Use& use: pass.uses)
+        {
+            VkAttachmentReference reference{ .attachment = *m_resources[use.resource].attachment, .layout = layoutFor(use) };
+
+            if(use.access == Access::ColorWrite)
+                colorRefs[s].push_back(reference);
+            else if(use.access == Access::InputRead)
+                inputRefs[s].push_back(reference);
+            else
+            {
+                depthRefs[s] = reference;
+                hasDepth = true;
+            }
+        }
+
+        // contents that live across this subpass without being touched by it
+        for(const auto& resource: m_resources)
+        {
+            bool used{ std::any_of(pass.uses.begin(), pass.uses.end(), [&](const Use& use) { return m_resources[use.resource].attachment == resource.attachment; }) };
+            if(resource.attachment && !used && resource.firstSubpass < s && s < resource.lastSubpass)
+                preserved[s].push_back(*resource.attachment);
+        }
+
+        subpasses[s] = VkSubpassDescription{
+            .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+            .inputAttachmentCount = static_cast<uint32_t>(inputRefs[s].size()),
+            .pInputAttachments = inputRefs[s].data(),
+            .colorAttachmentCount = static_cast<uint32_t>(colorRefs[s].size()),
+            .pColorAttachments = colorRefs[s].data(),
+            .pDepthStencilAttachment = hasDepth ? &depthRefs[s] : nullptr,
+            .preserveAttachmentCount = static_cast<uint32_t>(preserved[s].size()),
+            .pPreserveAttachments = preserved[s].data()
+        };
+    }
+
+    // one dependency per pair of subpasses, the masks of every attachment between them are merged
+    // and it stays by region only while every attachment it orders allows that
+    std::map<std::pair<uint32_t, uint32_t>, VkSubpassDependency> dependencies;
+    auto depend{ [&](uint32_t src, uint32_t dst, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, VkDependencyFlags flags) {
+        VkSubpassDependency& dependency{ dependencies.try_emplace(std::pair{ src, dst }, VkSubpassDependency{
+            .srcSubpass = src,
+            .dstSubpass = dst,
+            .dependencyFlags = flags
+        }).first->second };
+
+        dependency.dependencyFlags &= flags;
+        dependency.srcStageMask |= srcStage;
+        dependency.srcAccessMask |= srcAccess;
+        dependency.dstStageMask |= dstStage;
+        dependency.dstAccessMask |= dstAccess;
+    } };
+
+    for(RenderResource i{ 0 }; i < m_resources.size(); ++i)
+    {
+        const Resource& resource{ m_resources[i] };
+        if(!resource.attachment)
+            continue;
+
+        // against the previous frame's use of the same image, a swapchain image is ordered by the acquire semaphore instead
+        Access first{ resource.firstAccess };
+        depend(VK_SUBPASS_EXTERNAL, resource.firstSubpass, stageFor(first), resource.imported ? 0 : accessFor(first) & (VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT), stageFor(first), accessFor(first), 0);
+
+        // between consecutive subpasses using the attachment, every pixel only depends on the same pixel of the same image
+        std::optional<std::pair<uint32_t, Access>> previous;
+        for(const auto& pass: m_passes)
+        {
+            if(!pass.subpass)
+                continue;
+
+            auto use{ std::find_if(pass.uses.begin(), pass.uses.end(), [i](const Use& use) { return use.resource == i; }) };
+            if(use == pass.uses.end())
+                continue;
+
+            if(previous)
+                depend(previous->first, *pass.subpass, stageFor(previous->second), accessFor(previous->second), stageFor(use->access), accessFor(use->access), VK_DEPENDENCY_BY_REGION_BIT);
+
+            previous = std::pair{ *pass.subpass, use->access };
+        }
+
+        if(resource.imported)
+        {
+            VkPipelineStageFlags dstStage;
+            VkAccessFlags dstAccess;
+            finalStage(resource.finalLayout, dstStage, dstAccess);
+            depend(resource.lastSubpass, VK_SUBPASS_EXTERNAL, stageFor(resource.lastAccess), accessFor(resource.lastAccess), dstStage, dstAccess, 0);
+        }
+    }
+
+    // an aliased transient may only start once the one before it in the same memory is done
+    // not by region, with different formats a pixel of one doesn't map to the same bytes of the other
+    for(auto [from, to]: handoffs)
+    {
+        const Resource& previous{ m_resources[from] };
+        const Resource& next{ m_resources[to] };
+        depend(previous.lastSubpass, next.firstSubpass, stageFor(previous.lastAccess), accessFor(previous.lastAccess), stageFor(next.firstAccess), accessFor(next.firstAccess), 0);
+    }
+
+    m_dependencies.clear();
+    for(const auto& [key, dependency]: dependencies)
+        m_dependencies.push_back(dependency);
+
+    VkRenderPassCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+        .attachmentCount = static_cast<uint32_t>(attachments.size()),
+        .pAttachments = attachments.data(),
+        .subpassCount = static_cast<uint32_t>(subpasses.size()),
+        .pSubpasses = subpasses.data(),
+        .dependencyCount = static_cast<uint32_t>(m_dependencies.size()),
+        .pDependencies = m_dependencies.data()
+    };
+
+    VkRenderPass renderPass;
+    if(vkCreateRenderPass(device, &createInfo, nullptr, &renderPass) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating render pass");
+
+    return renderPass;
+}
+
+uint32_t RenderGraph::subpass(const std::string& pass) const
+{
+    auto it{ std::find_if(m_passes.begin(), m_passes.end(), [&](const Pass& candidate) { return candidate.name == pass; }) };
+    if(it == m_passes.end() || !it->subpass)
+        throw std::runtime_error("Failure while looking up subpass: " + pass + " is unknown or was culled");
+
+    return *it->subpass;
+}
+
+bool RenderGraph::isCulled(const std::string& pass) const
+{
+    auto it{ std::find_if(m_passes.begin(), m_passes.end(), [&](const Pass& candidate) { return candidate.name == pass; }) };
+    return it == m_passes.end() || !it->subpass;
+}
+
+RenderTargets RenderGraph::createTargets(Device& device, VkExtent2D extent, uint32_t copies) const
+{
+    RenderTargets targets{ .copies = copies };
+    targets.images.reserve(copies * m_transients.size());
+    targets.views.reserve(copies * m_transients.size());
+
+    for(uint32_t copy{ 0 }; copy < copies; ++copy)
+    {
+        // every group needs room for its largest member on a memory type all of them accept
+        std::vector<VkMemoryRequirements> groups(m_aliasGroupCount, VkMemoryRequirements{ .size = 0, .alignment = 1, .memoryTypeBits = ~0u });
+        size_t firstImage{ targets.images.size() };
+        VkDeviceSize separateBytes{ 0 };
+
+        for(RenderResource transient: m_transients)
+        {
+            const Resource& resource{ m_resources[transient] };
+            VkImageCreateInfo imageCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                .flags = 0,
+                .imageType = VK_IMAGE_TYPE_2D,
+                .format = resource.format,
+                .extent = VkExtent3D{
+                    .width = extent.width,
+                    .height = extent.height,
+                    .depth = 1
+                },
+                .mipLevels = 1,
+                .arrayLayers = 1,
+                .samples = VK_SAMPLE_COUNT_1_BIT,
+                .tiling = VK_IMAGE_TILING_OPTIMAL,
+                // only ever attachments, so tilers can keep them in on chip memory
+                .usage = resource.usage | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+            };
+
+            VkImage image;
+            if(vkCreateImage(device.device(), &imageCreateInfo, nullptr, &image) != VK_SUCCESS)
+                throw std::runtime_error("Failure while creating " + resource.name + " image");
+            targets.images.push_back(image);
+
+            VkMemoryRequirements requirements;
+            vkGetImageMemoryRequirements(device.device(), image, &requirements);
+            separateBytes += requirements.size;
+
+            VkMemoryRequirements& group{ groups[*resource.aliasGroup] };
+            group.size = std::max(group.size, requirements.size);
+            group.alignment = std::max(group.alignment, requirements.alignment);
+            group.memoryTypeBits &= requirements.memoryTypeBits;
+        }
+
+        VkDeviceSize groupedBytes{ 0 };
+        for(const auto& group: groups)
+        {
+            if(group.memoryTypeBits == 0)
+                throw std::runtime_error("Failure while aliasing transient attachments: no memory type fits all of them");
+
+            VkMemoryPropertyFlags properties{ VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT };
+            if(device.allocator().hasMemoryType(group.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT))
+            {
+                properties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+                targets.lazilyAllocated = true;
+            }
+
+            targets.memories.push_back(device.allocator().allocate(group, properties, ResourceTiling::Optimal));
+            groupedBytes += group.size;
+        }
+        targets.bytes += groupedBytes;
+        targets.aliasedBytes += separateBytes - groupedBytes;
+
+        for(size_t t{ 0 }; t < m_transients.size(); ++t)
+        {
+            const Resource& resource{ m_resources[m_transients[t]] };
+            const MemoryAllocation& memory{ targets.memories[copy * m_aliasGroupCount + *resource.aliasGroup] };
+            VkImage image{ targets.images[firstImage + t] };
+
+            if(vkBindImageMemory(device.device(), image, memory.memory, memory.offset) != VK_SUCCESS)
+                throw std::runtime_error("Failure while binding " + resource.name + " image memory");
+
+            bool depth{ isDepthFormat(resource.format) };
+            VkImageViewCreateInfo imageViewCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .image = image,
+                .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                .format = resource.format,
+                .subresourceRange = VkImageSubresourceRange{
+                    .aspectMask = depth ? VkImageAspectFlags{ VK_IMAGE_ASPECT_DEPTH_BIT } : VkImageAspectFlags{ VK_IMAGE_ASPECT_COLOR_BIT },
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1
+                }
+            };
+
+            VkImageView view;
+            if(vkCreateImageView(device.device(), &imageViewCreateInfo, nullptr, &view) != VK_SUCCESS)
+                throw std::runtime_error("Failure while creating " + resource.name + " image view");
+            targets.views.push_back(view);
+        }
+    }
+
+    return targets;
+}
+
+void RenderGraph::destroyTargets(Device& device, RenderTargets& targets)
+{
+    for(auto view: targets.views)
+        vkDestroyImageView(device.device(), view, nullptr);
+
+    for(auto image: targets.images)
+        vkDestroyImage(device.device(), image, nullptr);
+
+    for(auto& memory: targets.memories)
+        device.allocator().free(memory);
+
+    targets = RenderTargets{};
+}
+
+std::vector<VkImageView> RenderGraph::framebufferAttachments(const RenderTargets& targets, uint32_t copy, const std::vector<VkImageView>& importedViews) const
+{
+    if(importedViews.size() != m_imports.size())
+        throw std::runtime_error("Failure while creating framebuffer: expected a view for every imported attachment");
+
+    std::vector<VkImageView> views(m_clearValues.size(), VK_NULL_HANDLE);
+    for(size_t i{ 0 }; i < m_imports.size(); ++i)
+    {
+        const Resource& resource{ m_resources[m_imports[i]] };
+        if(resource.attachment)
+            views[*resource.attachment] = importedViews[i];
+    }
+
+    for(RenderResource transient: m_transients)
+    {
+        const Resource& resource{ m_resources[transient] };
+        views[*resource.attachment] = targets.views[copy * m_transients.size() + resource.transientIndex];
+    }
+
+    return views;
+}
@@ -0,0 +1,150 @@
+#ifndef CORE_RENDER_GRAPH_HPP
+#define CORE_RENDER_GRAPH_HPP
+
+#include "MemoryAllocator.hpp"
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Device;
+
+// index of an attachment declared on a RenderGraph
+using RenderResource = uint32_t;
+
+// images backing a graph's transient attachments for one extent, attachments with an alias group share its memory
+struct RenderTargets
+{
+    uint32_t copies{ 0 };
+    // copy-major, copies * transient attachment count
+    std::vector<VkImage> images;
+    std::vector<VkImageView> views;
+    // copy-major, copies * alias group count
+    std::vector<MemoryAllocation> memories;
+    // memory bound to the images, all copies
+    VkDeviceSize bytes{ 0 };
+    // bytes the aliasing saved over giving every transient image its own memory, all copies
+    VkDeviceSize aliasedBytes{ 0 };
+    // the memory is only committed where a tiler actually spills the attachments, often never
+    bool lazilyAllocated{ false };
+};
+
+/*
+ * Describes a frame as passes that declare the attachments they write and read, and compiles it into one
+ * VkRenderPass with a subpass per pass. Layouts, load and store ops, preserved attachments and the subpass
+ * dependencies are derived from the declarations, passes whose results never reach an imported attachment are culled.
+ * Transient attachments live only inside the render pass, the ones whose subpass ranges don't overlap are aliased onto
+ * the same memory, which is lazily allocated where the device offers it. Imported attachments are backed by views the caller provides, e.g. the swapchain images.
+ * Declare everything first and compile once, the compiled state is replaced by the next compile.
+ */
+class RenderGraph
+{
+public:
+    class PassBuilder
+    {
+    public:
+        PassBuilder& writeColor(RenderResource resource);
+        PassBuilder& writeDepth(RenderResource resource);
+        // depth test against an earlier pass's depth without writing it
+        PassBuilder& readDepth(RenderResource resource);
+        // subpassLoad in the fragment shader, the input attachment index is the order of the readInput calls
+        PassBuilder& readInput(RenderResource resource);
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& graph, uint32_t pass) : m_graph(graph), m_pass(pass) {}
+
+        RenderGraph& m_graph;
+        uint32_t m_pass;
+    };
+
+    // loaded as DONT_CARE without a clear value, stored and left in finalLayout
+    RenderResource importAttachment(std::string name, VkFormat format, VkImageLayout finalLayout, std::optional<VkClearValue> clear = std::nullopt);
+    // never stored, its contents die with the render pass
+    RenderResource createAttachment(std::string name, VkFormat format, std::optional<VkClearValue> clear = std::nullopt);
+    // passes execute in the order they are added
+    PassBuilder addPass(std::string name);
+
+    // the caller owns the render pass
+    VkRenderPass compile(VkDevice device);
+
+    // throws for culled passes
+    uint32_t subpass(const std::string& pass) const;
+    bool isCulled(const std::string& pass) const;
+    // in attachment order, for VkRenderPassBeginInfo
+    const std::vector<VkClearValue>& clearValues() const { return m_clearValues; }
+    uint32_t aliasGroupCount() const { return m_aliasGroupCount; }
+    // as handed to vkCreateRenderPass by the last compile
+    const std::vector<VkSubpassDependency>& dependencies() const { return m_dependencies; }
+
+    // copies independent sets of the transient attachments, e.g. one per framebuffer
+    RenderTargets createTargets(Device& device, VkExtent2D extent, uint32_t copies) const;
+    static void destroyTargets(Device& device, RenderTargets& targets);
+
+    // framebuffer attachments in attachment order, importedViews in the order the attachments were imported
+    std::vector<VkImageView> framebufferAttachments(const RenderTargets& targets, uint32_t copy, const std::vector<VkImageView>& importedViews) const;
+
+private:
+    enum class Access
+    {
+        ColorWrite,
+        DepthWrite,
+        DepthRead,
+        InputRead
+    };
+
+    struct Use
+    {
+        RenderResource resource;
+        Access access;
+    };
+
+    struct Resource
+    {
+        std::string name;
+        VkFormat format;
+        bool imported;
+        VkImageLayout finalLayout;
+        std::optional<VkClearValue> clear;
+
+        // filled in by compile
+        std::optional<uint32_t> attachment;
+        uint32_t firstSubpass{ 0 };
+        uint32_t lastSubpass{ 0 };
+        Access firstAccess{ Access::ColorWrite };
+        Access lastAccess{ Access::ColorWrite };
+        VkImageUsageFlags usage{ 0 };
+        std::optional<uint32_t> aliasGroup;
+        // slot among the transient images of one copy
+        uint32_t transientIndex{ 0 };
+    };
+
+    struct Pass
+    {
+        std::string name;
+        std::vector<Use> uses;
+
+        // filled in by compile
+        std::optional<uint32_t> subpass;
+    };
+
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+
+    std::vector<VkClearValue> m_clearValues;
+    std::vector<RenderResource> m_transients;
+    std::vector<RenderResource> m_imports;
+    std::vector<VkSubpassDependency> m_dependencies;
+    uint32_t m_aliasGroupCount{ 0 };
+
+    void addUse(uint32_t pass, RenderResource resource, Access access);
+    void cullPasses();
+    // pairs of transients that hand their memory over from the first to the second
+    std::vector<std::pair<RenderResource, RenderResource>> assignAliasGroups();
+};
+
+#endif //!CORE_RENDER_GRAPH_HPP
@@ -0,0 +1,211 @@
+#include "Scene.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    // LANES objects, one per component of the vector
+    using Lanes = glm::vec4;
+
+    size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+Entity Scene::create(const Transform& transform, const glm::vec4& boundingSphere, const Renderable& renderable)
+{
+    uint32_t slot;
+    if(m_freeSlots.empty())
+    {
+        slot = static_cast<uint32_t>(m_slots.size());
+        m_slots.emplace_back();
+    }
+    else
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+
+    size_t index{ m_entities.size() };
+    Entity entity{ .index = slot, .generation = m_slots[slot].generation };
+    m_slots[slot].dense = static_cast<uint32_t>(index);
+
+    m_entities.push_back(entity);
+    m_renderables.push_back(renderable);
+    resizeComponents(m_entities.size());
+
+    store(index, transform);
+    m_components[BoundX][index] = boundingSphere.x;
+    m_components[BoundY][index] = boundingSphere.y;
+    m_components[BoundZ][index] = boundingSphere.z;
+    m_components[BoundRadius][index] = boundingSphere.w;
+
+    return entity;
+}
+
+void Scene::destroy(Entity entity)
+{
+    uint32_t index{ denseIndex(entity) };
+    uint32_t last{ static_cast<uint32_t>(m_entities.size() - 1) };
+
+    // the last object fills the hole, the streams stay dense without shifting anything
+    if(index != last)
+    {
+        for(auto& component: m_components)
+            component[index] = component[last];
+
+        m_renderables[index] = m_renderables[last];
+        m_entities[index] = m_entities[last];
+        m_slots[m_entities[index].index].dense = index;
+    }
+
+    m_renderables.pop_back();
+    m_entities.pop_back();
+    resizeComponents(m_entities.size());
+
+    Slot& slot{ m_slots[entity.index] };
+    slot.dense = NO_OBJECT;
+    ++slot.generation;
+    m_freeSlots.push_back(entity.index);
+}
+
+bool Scene::isAlive(Entity entity) const
+{
+    return entity.index < m_slots.size() && m_slots[entity.index].generation == entity.generation && m_slots[entity.index].dense != NO_OBJECT;
+}
+
+void Scene::setTransform(Entity entity, const Transform& transform)
+{
+    store(denseIndex(entity), transform);
+}
+
+Transform Scene::transform(Entity entity) const
+{
+    uint32_t i{ denseIndex(entity) };
+    const auto& c{ m_components };
+
+    return Transform{
+        .position = { c[PositionX][i], c[PositionY][i], c[PositionZ][i] },
+        .rotation = glm::quat{ c[RotationW][i], c[RotationX][i], c[RotationY][i], c[RotationZ][i] },
+        .scale = { c[ScaleX][i], c[ScaleY][i], c[ScaleZ][i] }
+    };
+}
+
+void Scene::reserve(size_t count)
+{
+    for(auto& component: m_components)
+        component.reserve(alignUp(count, LANES));
+
+    m_renderables.reserve(count);
+    m_entities.reserve(count);
+    m_slots.reserve(count);
+}
+
+glm::mat4 Scene::worldMatrix(size_t index) const
+{
+    Transform transform{ this->transform(m_entities[index]) };
+    return glm::scale(glm::translate(glm::mat4{ 1.f }, transform.position) * glm::mat4_cast(transform.rotation), transform.scale);
+}
+
+void Scene::writeObjects(ObjectData* destination, size_t first, size_t count) const
+{
+    const auto& c{ m_components };
+    auto load{ [&c](Component component, size_t i) { return glm::make_vec4(&c[component][i]); } };
+
+    // batches start on a multiple of LANES, so a range starting mid batch computes a few lanes it doesn't write
+    size_t end{ first + count };
+    for(size_t batch{ first - first % LANES }; batch < end; batch += LANES)
+    {
+        Lanes x{ load(RotationX, batch) }, y{ load(RotationY, batch) }, z{ load(RotationZ, batch) }, w{ load(RotationW, batch) };
+        Lanes sx{ load(ScaleX, batch) }, sy{ load(ScaleY, batch) }, sz{ load(ScaleZ, batch) };
+
+        // glm::mat4_cast with the columns scaled, for LANES objects at once
+        Lanes xx{ x * x }, yy{ y * y }, zz{ z * z };
+        Lanes xy{ x * y }, xz{ x * z }, yz{ y * z };
+        Lanes wx{ w * x }, wy{ w * y }, wz{ w * z };
+
+        std::array<Lanes, 12> columns{
+            sx * (1.f - 2.f * (yy + zz)), sx * (2.f * (xy + wz)), sx * (2.f * (xz - wy)),
+            sy * (2.f * (xy - wz)), sy * (1.f - 2.f * (xx + zz)), sy * (2.f * (yz + wx)),
+            sz * (2.f * (xz + wy)), sz * (2.f * (yz - wx)), sz * (1.f - 2.f * (xx + yy)),
+            load(PositionX, batch), load(PositionY, batch), load(PositionZ, batch)
+        };
+        Lanes bx{ load(BoundX, batch) }, by{ load(BoundY, batch) }, bz{ load(BoundZ, batch) }, radius{ load(BoundRadius, batch) };
+
+        size_t firstLane{ std::max(batch, first) - batch };
+        size_t lastLane{ std::min(batch + LANES, end) - batch };
+        for(size_t lane{ firstLane }; lane < lastLane; ++lane)
+        {
+            const auto l{ static_cast<glm::length_t>(lane) };
+
+            // whole objects in ascending order, write combined memory sees full sequential lines
+            destination[batch + lane - first] = ObjectData{
+                .transform = glm::mat4{
+                    columns[0][l], columns[1][l], columns[2][l], 0.f,
+                    columns[3][l], columns[4][l], columns[5][l], 0.f,
+                    columns[6][l], columns[7][l], columns[8][l], 0.f,
+                    columns[9][l], columns[10][l], columns[11][l], 1.f },
+                .boundingSphere = glm::vec4{ bx[l], by[l], bz[l], radius[l] }
+            };
+        }
+    }
+}
+
+void Scene::writeObjects(ObjectData* destination, ThreadPool& threadPool) const
+{
+    size_t count{ size() };
+    if(count < PARALLEL_THRESHOLD)
+    {
+        writeObjects(destination, 0, count);
+        return;
+    }
+
+    // whole batches per task, no two tasks share one
+    uint32_t taskCount{ threadPool.size() + 1 };
+    size_t chunkSize{ alignUp((count + taskCount - 1) / taskCount, LANES) };
+    threadPool.parallelFor(taskCount, [&](uint32_t task) {
+        size_t first{ task * chunkSize };
+        if(first < count)
+            writeObjects(destination + first, first, std::min(chunkSize, count - first));
+    });
+}
+
+uint32_t Scene::denseIndex(Entity entity) const
+{
+    if(!isAlive(entity))
+        throw std::runtime_error("Failure while accessing scene: the entity was destroyed");
+
+    return m_slots[entity.index].dense;
+}
+
+void Scene::store(size_t index, const Transform& transform)
+{
+    auto& c{ m_components };
+
+    c[PositionX][index] = transform.position.x;
+    c[PositionY][index] = transform.position.y;
+    c[PositionZ][index] = transform.position.z;
+    c[RotationX][index] = transform.rotation.x;
+    c[RotationY][index] = transform.rotation.y;
+    c[RotationZ][index] = transform.rotation.z;
+    c[RotationW][index] = transform.rotation.w;
+    c[ScaleX][index] = transform.scale.x;
+    c[ScaleY][index] = transform.scale.y;
+    c[ScaleZ][index] = transform.scale.z;
+}
+
+void Scene::resizeComponents(size_t count)
+{
+    size_t padded{ alignUp(count, LANES) };
+    for(auto& component: m_components)
+    {
+        // the padding is zeroed again after a destroy, stale objects never show up in a batch's spare lanes
+        component.resize(count, 0.f);
+        component.resize(padded, 0.f);
+    }
+}
@@ -0,0 +1,118 @@
+#ifndef CORE_SCENE_HPP
+#define CORE_SCENE_HPP
+
+#include "ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Model;
+class Pipeline;
+
+// per object data read by the culling and the vertex shader, matches the std430 layout of ObjectData in the shaders
+struct ObjectData
+{
+    glm::mat4 transform;
+    // model space bounding sphere, xyz is the center and w the radius
+    glm::vec4 boundingSphere;
+};
+
+// stays valid while the entity lives, a destroyed entity's handle never refers to a later one
+struct Entity
+{
+    uint32_t index;
+    uint32_t generation;
+
+    bool operator==(const Entity&) const = default;
+};
+
+struct Transform
+{
+    glm::vec3 position{ 0.f };
+    glm::quat rotation{ 1.f, 0.f, 0.f, 0.f };
+    glm::vec3 scale{ 1.f };
+};
+
+struct Renderable
+{
+    // the slot owning the pipeline, drawn with the fallback while the slot is empty
+    const std::shared_ptr<Pipeline>* pipeline;
+    Model* model;
+};
+
+/*
+ * The objects in the world, stored as one tightly packed float stream per component (position x, position y, ...)
+ * in dense order, so an update walks each stream linearly and processes LANES objects per step in glm::vec4 lanes.
+ * Entities are handles into a slot map, destroying one moves the last object into the hole and keeps the streams dense.
+ * Not thread safe, writeObjects only reads and may be split over a thread pool.
+ */
+class Scene
+{
+public:
+    enum Component : size_t
+    {
+        PositionX, PositionY, PositionZ,
+        RotationX, RotationY, RotationZ, RotationW,
+        ScaleX, ScaleY, ScaleZ,
+        BoundX, BoundY, BoundZ, BoundRadius,
+        COMPONENT_COUNT
+    };
+
+    static constexpr size_t LANES{ 4 };
+    // below this many objects a single thread is faster than waking the pool
+    static constexpr size_t PARALLEL_THRESHOLD{ 16384 };
+
+    Entity create(const Transform& transform, const glm::vec4& boundingSphere, const Renderable& renderable);
+    void destroy(Entity entity);
+    bool isAlive(Entity entity) const;
+
+    void setTransform(Entity entity, const Transform& transform);
+    Transform transform(Entity entity) const;
+
+    void reserve(size_t count);
+    size_t size() const { return m_entities.size(); }
+
+    // dense order, index i of these belongs to object i of writeObjects
+    const std::vector<Entity>& entities() const { return m_entities; }
+    const std::vector<Renderable>& renderables() const { return m_renderables; }
+
+    // a component's dense stream, readable in whole batches of LANES up to alignUp(size(), LANES)
+    const float* component(Component component) const { return m_components[component].data(); }
+
+    // a single object's world matrix, for the few objects drawn one by one
+    glm::mat4 worldMatrix(size_t index) const;
+
+    // world matrices and bounds of objects [first, first + count) into destination[0, count), only ever written to,
+    // so destination may be write combined GPU memory
+    void writeObjects(ObjectData* destination, size_t first, size_t count) const;
+    // every object, split across the pool for large scenes
+    void writeObjects(ObjectData* destination, ThreadPool& threadPool) const;
+
+private:
+    static constexpr uint32_t NO_OBJECT{ ~0u };
+
+    struct Slot
+    {
+        uint32_t dense{ NO_OBJECT };
+        uint32_t generation{ 0 };
+    };
+
+    // padded with zeros to a multiple of LANES, a batch never needs a scalar tail
+    std::array<std::vector<float>, COMPONENT_COUNT> m_components;
+    std::vector<Renderable> m_renderables;
+    std::vector<Entity> m_entities;
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+
+    uint32_t denseIndex(Entity entity) const;
+    void store(size_t index, const Transform& transform);
+    void resizeComponents(size_t count);
+};
+
+#endif //!CORE_SCENE_HPP
@@ -0,0 +1,117 @@
+#include "SceneCuller.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+
+namespace
+{
+    // Scene::LANES objects, one per component of the vector
+    using Lanes = glm::vec4;
+
+    size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+Frustum Frustum::fromViewProjection(const glm::mat4& viewProjection)
+{
+    // rows of the column major matrix
+    auto row{ [&](int i) { return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]); } };
+
+    Frustum frustum{ .planes = {
+        row(3) + row(0),
+        row(3) - row(0),
+        row(3) + row(1),
+        row(3) - row(1),
+        row(2),
+        row(3) - row(2)
+    } };
+
+    for(auto& plane: frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+
+    return frustum;
+}
+
+SceneCuller::SceneCuller(ThreadPool& threadPool)
+    : m_threadPool(threadPool), m_taskVisible(threadPool.size() + 1)
+{
+}
+
+const std::vector<uint32_t>& SceneCuller::cull(const Scene& scene, const CullView& view)
+{
+    size_t count{ scene.size() };
+    m_visible.clear();
+
+    if(count < Scene::PARALLEL_THRESHOLD)
+    {
+        cullRange(scene, view, 0, count, m_visible);
+        return m_visible;
+    }
+
+    // whole batches per task, every task appends to its own list and the lists are joined in order
+    uint32_t taskCount{ static_cast<uint32_t>(m_taskVisible.size()) };
+    size_t chunkSize{ alignUp((count + taskCount - 1) / taskCount, Scene::LANES) };
+    m_threadPool.parallelFor(taskCount, [&](uint32_t task) {
+        std::vector<uint32_t>& visible{ m_taskVisible[task] };
+        visible.clear();
+
+        size_t first{ task * chunkSize };
+        if(first < count)
+            cullRange(scene, view, first, std::min(chunkSize, count - first), visible);
+    });
+
+    for(const auto& visible: m_taskVisible)
+        m_visible.insert(m_visible.end(), visible.begin(), visible.end());
+
+    return m_visible;
+}
+
+void SceneCuller::cullRange(const Scene& scene, const CullView& view, size_t first, size_t count, std::vector<uint32_t>& visible)
+{
+    auto load{ [&scene](Scene::Component component, size_t i) { return glm::make_vec4(scene.component(component) + i); } };
+
+    std::array<std::array<Lanes, 4>, 6> planes;
+    for(size_t i{ 0 }; i < planes.size(); ++i)
+    {
+        const glm::vec4& plane{ view.frustum.planes[i] };
+        planes[i] = { Lanes{ plane.x }, Lanes{ plane.y }, Lanes{ plane.z }, Lanes{ plane.w } };
+    }
+
+    // batches start on a multiple of LANES, so a range starting mid batch tests a few lanes it doesn't report
+    size_t end{ first + count };
+    for(size_t batch{ first - first % Scene::LANES }; batch < end; batch += Scene::LANES)
+    {
+        Lanes qx{ load(Scene::RotationX, batch) }, qy{ load(Scene::RotationY, batch) }, qz{ load(Scene::RotationZ, batch) }, qw{ load(Scene::RotationW, batch) };
+        Lanes sx{ load(Scene::ScaleX, batch) }, sy{ load(Scene::ScaleY, batch) }, sz{ load(Scene::ScaleZ, batch) };
+
+        // model space center, scaled and then rotated as v + w * t + cross(q.xyz, t) with t = 2 * cross(q.xyz, v)
+        Lanes vx{ sx * load(Scene::BoundX, batch) }, vy{ sy * load(Scene::BoundY, batch) }, vz{ sz * load(Scene::BoundZ, batch) };
+        Lanes tx{ 2.f * (qy * vz - qz * vy) }, ty{ 2.f * (qz * vx - qx * vz) }, tz{ 2.f * (qx * vy - qy * vx) };
+
+        Lanes cx{ load(Scene::PositionX, batch) + vx + qw * tx + (qy * tz - qz * ty) };
+        Lanes cy{ load(Scene::PositionY, batch) + vy + qw * ty + (qz * tx - qx * tz) };
+        Lanes cz{ load(Scene::PositionZ, batch) + vz + qw * tz + (qx * ty - qy * tx) };
+        Lanes radius{ load(Scene::BoundRadius, batch) * glm::max(glm::abs(sx), glm::max(glm::abs(sy), glm::abs(sz))) };
+
+        // the plane the sphere's center is farthest outside of decides
+        Lanes nearest{ planes[0][0] * cx + planes[0][1] * cy + planes[0][2] * cz + planes[0][3] };
+        for(size_t i{ 1 }; i < planes.size(); ++i)
+            nearest = glm::min(nearest, planes[i][0] * cx + planes[i][1] * cy + planes[i][2] * cz + planes[i][3]);
+
+        Lanes dx{ cx - view.position.x }, dy{ cy - view.position.y }, dz{ cz - view.position.z };
+        Lanes distanceSquared{ dx * dx + dy * dy + dz * dz };
+        Lanes reach{ view.maxDistance + radius };
+
+        size_t firstLane{ std::max(batch, first) - batch };
+        size_t lastLane{ std::min(batch + Scene::LANES, end) - batch };
+        for(size_t lane{ firstLane }; lane < lastLane; ++lane)
+        {
+            const auto l{ static_cast<glm::length_t>(lane) };
+            if(nearest[l] >= -radius[l] && distanceSquared[l] <= reach[l] * reach[l])
+                visible.push_back(static_cast<uint32_t>(batch + lane));
+        }
+    }
+}
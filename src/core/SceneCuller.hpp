@@ -0,0 +1,56 @@
+#ifndef CORE_SCENE_CULLER_HPP
+#define CORE_SCENE_CULLER_HPP
+
+#include "Scene.hpp"
+#include "ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+struct Frustum
+{
+    // normalized, pointing inwards, a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for all of them
+    std::array<glm::vec4, 6> planes;
+
+    // uses Vulkan's 0..1 clip depth
+    static Frustum fromViewProjection(const glm::mat4& viewProjection);
+};
+
+struct CullView
+{
+    Frustum frustum;
+    glm::vec3 position{ 0.f };
+    // objects whose bounding sphere lies entirely farther from position are culled
+    float maxDistance{ std::numeric_limits<float>::infinity() };
+};
+
+/*
+ * Visibility on the CPU, for wherever the GPU driven path isn't available.
+ * Tests the scene's bounding spheres in world space against the frustum and the view distance, Scene::LANES objects
+ * per step straight from the scene's component streams, and splits large scenes across the thread pool.
+ * The result is a compact list of dense scene indices in ascending order, ready to be recorded.
+ */
+class SceneCuller
+{
+public:
+    explicit SceneCuller(ThreadPool& threadPool);
+
+    // valid until the next call, must not be called from inside a pool task
+    const std::vector<uint32_t>& cull(const Scene& scene, const CullView& view);
+    const std::vector<uint32_t>& visible() const { return m_visible; }
+
+    // single threaded over objects [first, first + count), appends to visible
+    static void cullRange(const Scene& scene, const CullView& view, size_t first, size_t count, std::vector<uint32_t>& visible);
+
+private:
+    ThreadPool& m_threadPool;
+    std::vector<std::vector<uint32_t>> m_taskVisible;
+    std::vector<uint32_t> m_visible;
+};
+
+#endif //!CORE_SCENE_CULLER_HPP
@@ -0,0 +1,64 @@
+#include "ShaderCompiler.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+ShaderCompiler::ShaderCompiler(const std::filesystem::path& cacheDirectory, const std::string& glslc)
+    : m_cacheDirectory(cacheDirectory), m_glslc(glslc)
+{
+    std::filesystem::create_directories(m_cacheDirectory);
+}
+
+bool ShaderCompiler::compile(const std::filesystem::path& source, const std::filesystem::path& output)
+{
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hashFile(source) << ".spv";
+    std::filesystem::path cached{ m_cacheDirectory / name.str() };
+    bool cacheHit{ std::filesystem::exists(cached) };
+
+    if(!cacheHit)
+    {
+        // compiled next to the cache entry and renamed, an interrupted compile never leaves a broken entry behind
+        std::filesystem::path compiling{ cached.string() + ".tmp" };
+        std::string command{ "\"" + m_glslc + "\" \"" + source.string() + "\" -o \"" + compiling.string() + "\"" };
+
+        if(std::system(command.c_str()) != 0)
+            throw std::runtime_error("Failure while compiling shader: " + source.string());
+
+        std::filesystem::rename(compiling, cached);
+    }
+
+    std::filesystem::path staging{ output.string() + ".tmp" };
+    std::filesystem::copy_file(cached, staging, std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::rename(staging, output);
+
+    return cacheHit;
+}
+
+uint64_t ShaderCompiler::hashFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if(!file.is_open())
+        throw std::runtime_error("Failure opening the file at: " + path.string());
+
+    std::vector<char> content{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    // FNV-1a, the stage is part of the key since glslc derives it from the extension
+    uint64_t hash{ 14695981039346656037ull };
+    auto mix{ [&hash](char byte) {
+        hash ^= static_cast<uint8_t>(byte);
+        hash *= 1099511628211ull;
+    } };
+
+    for(char byte: path.extension().string())
+        mix(byte);
+    for(char byte: content)
+        mix(byte);
+
+    return hash;
+}
@@ -0,0 +1,36 @@
+#ifndef CORE_SHADER_COMPILER_HPP
+#define CORE_SHADER_COMPILER_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+/*
+ * Compiles GLSL with glslc at runtime.
+ * Results are cached by a hash of the source content, so reverting a change or touching a file
+ * without editing it doesn't invoke the compiler again. Sources with #include are hashed without their includes.
+ */
+class ShaderCompiler
+{
+public:
+#ifdef GLSLC_EXECUTABLE
+    static constexpr const char* DEFAULT_GLSLC{ GLSLC_EXECUTABLE };
+#else
+    static constexpr const char* DEFAULT_GLSLC{ "glslc" };
+#endif
+    static constexpr const char* DEFAULT_CACHE_DIRECTORY{ "shader_cache" };
+
+    explicit ShaderCompiler(const std::filesystem::path& cacheDirectory = DEFAULT_CACHE_DIRECTORY, const std::string& glslc = DEFAULT_GLSLC);
+
+    // output is replaced atomically, a pipeline reading it concurrently sees either the old or the new SPIR-V
+    // returns whether the result came from the cache
+    bool compile(const std::filesystem::path& source, const std::filesystem::path& output);
+
+private:
+    std::filesystem::path m_cacheDirectory;
+    std::string m_glslc;
+
+    static uint64_t hashFile(const std::filesystem::path& path);
+};
+
+#endif //!CORE_SHADER_COMPILER_HPP
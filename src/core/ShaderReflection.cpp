@@ -0,0 +1,560 @@
+#include "ShaderReflection.hpp"
+#include "Pipeline.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+    constexpr uint32_t SPIRV_MAGIC{ 0x07230203 };
+    constexpr size_t SPIRV_HEADER_WORDS{ 5 };
+
+    // the subset of the SPIR-V grammar the reflection needs, values from the SPIR-V specification
+    enum Op : uint32_t
+    {
+        OpEntryPoint = 15,
+        OpTypeBool = 20,
+        OpTypeInt = 21,
+        OpTypeFloat = 22,
+        OpTypeVector = 23,
+        OpTypeMatrix = 24,
+        OpTypeImage = 25,
+        OpTypeSampler = 26,
+        OpTypeSampledImage = 27,
+        OpTypeArray = 28,
+        OpTypeRuntimeArray = 29,
+        OpTypeStruct = 30,
+        OpTypePointer = 32,
+        OpConstant = 43,
+        OpSpecConstant = 50,
+        OpFunction = 54,
+        OpVariable = 59,
+        OpDecorate = 71,
+        OpMemberDecorate = 72
+    };
+
+    enum Decoration : uint32_t
+    {
+        DecorationBlock = 2,
+        DecorationBufferBlock = 3,
+        DecorationRowMajor = 4,
+        DecorationArrayStride = 6,
+        DecorationMatrixStride = 7,
+        DecorationBuiltIn = 11,
+        DecorationLocation = 30,
+        DecorationBinding = 33,
+        DecorationDescriptorSet = 34,
+        DecorationOffset = 35
+    };
+
+    enum StorageClass : uint32_t
+    {
+        StorageClassUniformConstant = 0,
+        StorageClassInput = 1,
+        StorageClassUniform = 2,
+        StorageClassPushConstant = 9,
+        StorageClassStorageBuffer = 12
+    };
+
+    enum ExecutionModel : uint32_t
+    {
+        ExecutionModelVertex = 0,
+        ExecutionModelTessellationControl = 1,
+        ExecutionModelTessellationEvaluation = 2,
+        ExecutionModelGeometry = 3,
+        ExecutionModelFragment = 4,
+        ExecutionModelGLCompute = 5
+    };
+
+    constexpr uint32_t DIM_BUFFER{ 5 };
+    constexpr uint32_t DIM_SUBPASS_DATA{ 6 };
+    // OpTypeImage's Sampled operand, 2 means read and written without a sampler
+    constexpr uint32_t IMAGE_STORAGE{ 2 };
+
+    struct Type
+    {
+        uint32_t op{ 0 };
+        // component of a vector, column of a matrix, element of an array, pointee of a pointer
+        uint32_t element{ 0 };
+        // components of a vector or columns of a matrix
+        uint32_t count{ 1 };
+        // id of the constant holding an array's length
+        uint32_t lengthId{ 0 };
+        uint32_t width{ 0 };
+        bool isSigned{ false };
+        uint32_t storageClass{ 0 };
+        uint32_t dim{ 0 };
+        uint32_t sampled{ 0 };
+        std::vector<uint32_t> members;
+    };
+
+    struct Decorations
+    {
+        std::optional<uint32_t> location;
+        std::optional<uint32_t> binding;
+        std::optional<uint32_t> set;
+        std::optional<uint32_t> arrayStride;
+        bool block{ false };
+        bool bufferBlock{ false };
+        bool builtIn{ false };
+    };
+
+    struct MemberDecorations
+    {
+        uint32_t offset{ 0 };
+        std::optional<uint32_t> matrixStride;
+        bool rowMajor{ false };
+        bool builtIn{ false };
+    };
+
+    struct Variable
+    {
+        uint32_t id;
+        uint32_t type;
+        uint32_t storageClass;
+    };
+
+    // the declarations in front of the first function, which is all a module's interface consists of
+    class Module
+    {
+    public:
+        explicit Module(const std::vector<char>& code)
+        {
+            if(code.size() % sizeof(uint32_t) != 0 || code.size() < SPIRV_HEADER_WORDS * sizeof(uint32_t))
+                throw std::runtime_error("Failure while reflecting shader: not a SPIR-V module");
+
+            std::vector<uint32_t> words(code.size() / sizeof(uint32_t));
+            std::memcpy(words.data(), code.data(), code.size());
+
+            if(words[0] != SPIRV_MAGIC)
+                throw std::runtime_error("Failure while reflecting shader: not a SPIR-V module");
+
+            for(size_t offset{ SPIRV_HEADER_WORDS }; offset < words.size();)
+            {
+                uint32_t wordCount{ words[offset] >> 16 };
+                uint32_t op{ words[offset] & 0xffffu };
+
+                if(wordCount == 0 || offset + wordCount > words.size())
+                    throw std::runtime_error("Failure while reflecting shader: truncated instruction");
+                if(op == OpFunction)
+                    break;
+
+                parse(op, &words[offset + 1], wordCount - 1);
+                offset += wordCount;
+            }
+        }
+
+        VkShaderStageFlags stage{ 0 };
+        uint32_t executionModel{ 0 };
+        std::unordered_map<uint32_t, Type> types;
+        std::unordered_map<uint32_t, uint32_t> constants;
+        std::unordered_map<uint32_t, Decorations> decorations;
+        std::map<std::pair<uint32_t, uint32_t>, MemberDecorations> memberDecorations;
+        std::vector<Variable> variables;
+
+        const Type& type(uint32_t id) const
+        {
+            auto it{ types.find(id) };
+            if(it == types.end())
+                throw std::runtime_error("Failure while reflecting shader: unknown type id " + std::to_string(id));
+            return it->second;
+        }
+
+        const Decorations& decoration(uint32_t id) const
+        {
+            static const Decorations none;
+            auto it{ decorations.find(id) };
+            return it == decorations.end() ? none : it->second;
+        }
+
+        const MemberDecorations& memberDecoration(uint32_t structId, uint32_t member) const
+        {
+            static const MemberDecorations none;
+            auto it{ memberDecorations.find({ structId, member }) };
+            return it == memberDecorations.end() ? none : it->second;
+        }
+
+        uint32_t arrayLength(const Type& array) const
+        {
+            auto it{ constants.find(array.lengthId) };
+            if(it == constants.end())
+                throw std::runtime_error("Failure while reflecting shader: array lengths must be constants");
+            return it->second;
+        }
+
+        // bytes the type occupies inside an explicitly laid out block
+        uint32_t size(uint32_t id, const MemberDecorations& member = {}) const
+        {
+            const Type& t{ type(id) };
+            switch(t.op)
+            {
+            case OpTypeBool:
+                return 4;
+            case OpTypeInt:
+            case OpTypeFloat:
+                return t.width / 8;
+            case OpTypeVector:
+                return t.count * size(t.element);
+            case OpTypeMatrix:
+            {
+                const Type& column{ type(t.element) };
+                uint32_t vectors{ member.rowMajor ? column.count : t.count };
+                return vectors * member.matrixStride.value_or(size(t.element));
+            }
+            case OpTypeArray:
+            {
+                auto stride{ decoration(id).arrayStride };
+                return arrayLength(t) * (stride ? *stride : size(t.element, member));
+            }
+            case OpTypeStruct:
+            {
+                uint32_t end{ 0 };
+                for(uint32_t i{ 0 }; i < t.members.size(); ++i)
+                {
+                    const MemberDecorations& layout{ memberDecoration(id, i) };
+                    end = std::max(end, layout.offset + size(t.members[i], layout));
+                }
+                return end;
+            }
+            default:
+                throw std::runtime_error("Failure while reflecting shader: unsized type in a block");
+            }
+        }
+
+    private:
+        void parse(uint32_t op, const uint32_t* operands, uint32_t count)
+        {
+            switch(op)
+            {
+            case OpEntryPoint:
+                if(stage != 0)
+                    throw std::runtime_error("Failure while reflecting shader: modules with several entry points are not supported");
+                executionModel = operands[0];
+                stage = stageFlag(executionModel);
+                break;
+            case OpTypeBool:
+            case OpTypeSampler:
+                types[operands[0]] = Type{ .op = op };
+                break;
+            case OpTypeInt:
+                types[operands[0]] = Type{ .op = op, .width = operands[1], .isSigned = operands[2] != 0 };
+                break;
+            case OpTypeFloat:
+                types[operands[0]] = Type{ .op = op, .width = operands[1] };
+                break;
+            case OpTypeVector:
+            case OpTypeMatrix:
+                types[operands[0]] = Type{ .op = op, .element = operands[1], .count = operands[2] };
+                break;
+            case OpTypeImage:
+                types[operands[0]] = Type{ .op = op, .element = operands[1], .dim = operands[2], .sampled = operands[6] };
+                break;
+            case OpTypeSampledImage:
+            case OpTypeRuntimeArray:
+                types[operands[0]] = Type{ .op = op, .element = operands[1] };
+                break;
+            case OpTypeArray:
+                types[operands[0]] = Type{ .op = op, .element = operands[1], .lengthId = operands[2] };
+                break;
+            case OpTypeStruct:
+                types[operands[0]] = Type{ .op = op, .members = std::vector<uint32_t>(operands + 1, operands + count) };
+                break;
+            case OpTypePointer:
+                types[operands[0]] = Type{ .op = op, .element = operands[2], .storageClass = operands[1] };
+                break;
+            case OpConstant:
+            case OpSpecConstant:
+                // array lengths only need the low word, a specialized length keeps its default
+                if(count >= 3)
+                    constants[operands[1]] = operands[2];
+                break;
+            case OpVariable:
+                variables.push_back(Variable{ .id = operands[1], .type = operands[0], .storageClass = operands[2] });
+                break;
+            case OpDecorate:
+                decorate(decorations[operands[0]], operands[1], count > 2 ? operands[2] : 0);
+                break;
+            case OpMemberDecorate:
+                decorateMember(memberDecorations[{ operands[0], operands[1] }], operands[2], count > 3 ? operands[3] : 0);
+                break;
+            default:
+                break;
+            }
+        }
+
+        static void decorate(Decorations& decorations, uint32_t decoration, uint32_t value)
+        {
+            switch(decoration)
+            {
+            case DecorationBlock: decorations.block = true; break;
+            case DecorationBufferBlock: decorations.bufferBlock = true; break;
+            case DecorationArrayStride: decorations.arrayStride = value; break;
+            case DecorationBuiltIn: decorations.builtIn = true; break;
+            case DecorationLocation: decorations.location = value; break;
+            case DecorationBinding: decorations.binding = value; break;
+            case DecorationDescriptorSet: decorations.set = value; break;
+            default: break;
+            }
+        }
+
+        static void decorateMember(MemberDecorations& decorations, uint32_t decoration, uint32_t value)
+        {
+            switch(decoration)
+            {
+            case DecorationOffset: decorations.offset = value; break;
+            case DecorationMatrixStride: decorations.matrixStride = value; break;
+            case DecorationRowMajor: decorations.rowMajor = true; break;
+            case DecorationBuiltIn: decorations.builtIn = true; break;
+            default: break;
+            }
+        }
+
+        static VkShaderStageFlags stageFlag(uint32_t executionModel)
+        {
+            switch(executionModel)
+            {
+            case ExecutionModelVertex: return VK_SHADER_STAGE_VERTEX_BIT;
+            case ExecutionModelTessellationControl: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+            case ExecutionModelTessellationEvaluation: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+            case ExecutionModelGeometry: return VK_SHADER_STAGE_GEOMETRY_BIT;
+            case ExecutionModelFragment: return VK_SHADER_STAGE_FRAGMENT_BIT;
+            case ExecutionModelGLCompute: return VK_SHADER_STAGE_COMPUTE_BIT;
+            default: throw std::runtime_error("Failure while reflecting shader: unsupported execution model");
+            }
+        }
+    };
+
+    VkDescriptorType descriptorType(const Module& module, uint32_t typeId, uint32_t storageClass)
+    {
+        const Type& type{ module.type(typeId) };
+
+        if(storageClass == StorageClassStorageBuffer)
+            return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        if(storageClass == StorageClassUniform)
+            return module.decoration(typeId).bufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+        switch(type.op)
+        {
+        case OpTypeSampler:
+            return VK_DESCRIPTOR_TYPE_SAMPLER;
+        case OpTypeSampledImage:
+            return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        case OpTypeImage:
+            if(type.dim == DIM_BUFFER)
+                return type.sampled == IMAGE_STORAGE ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            if(type.dim == DIM_SUBPASS_DATA)
+                return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            return type.sampled == IMAGE_STORAGE ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        default:
+            throw std::runtime_error("Failure while reflecting shader: unsupported descriptor type");
+        }
+    }
+
+    VkFormat vertexFormat(const Module& module, uint32_t typeId)
+    {
+        const Type& type{ module.type(typeId) };
+        uint32_t components{ type.op == OpTypeVector ? type.count : 1 };
+        const Type& scalar{ type.op == OpTypeVector ? module.type(type.element) : type };
+
+        if((scalar.op != OpTypeFloat && scalar.op != OpTypeInt) || scalar.width != 32 || components > 4)
+            throw std::runtime_error("Failure while reflecting shader: vertex inputs must be 32 bit scalars or vectors");
+
+        constexpr VkFormat FLOAT_FORMATS[]{ VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+        constexpr VkFormat SINT_FORMATS[]{ VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+        constexpr VkFormat UINT_FORMATS[]{ VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+        if(scalar.op == OpTypeFloat)
+            return FLOAT_FORMATS[components - 1];
+        return scalar.isSigned ? SINT_FORMATS[components - 1] : UINT_FORMATS[components - 1];
+    }
+}
+
+ShaderReflection ShaderReflection::reflect(const std::vector<char>& code)
+{
+    Module module{ code };
+
+    ShaderReflection reflection;
+    reflection.stages = module.stage;
+
+    uint32_t pushConstantsBegin{ std::numeric_limits<uint32_t>::max() };
+    uint32_t pushConstantsEnd{ 0 };
+
+    for(const Variable& variable: module.variables)
+    {
+        const Type& pointer{ module.type(variable.type) };
+        const Decorations& decorations{ module.decoration(variable.id) };
+
+        switch(variable.storageClass)
+        {
+        case StorageClassUniformConstant:
+        case StorageClassUniform:
+        case StorageClassStorageBuffer:
+        {
+            if(!decorations.binding)
+                throw std::runtime_error("Failure while reflecting shader: resource without a binding");
+
+            uint32_t typeId{ pointer.element };
+            uint32_t count{ 1 };
+            for(const Type* type{ &module.type(typeId) }; type->op == OpTypeArray || type->op == OpTypeRuntimeArray; type = &module.type(typeId))
+            {
+                if(type->op == OpTypeRuntimeArray)
+                    throw std::runtime_error("Failure while reflecting shader: runtime sized descriptor arrays are not supported");
+
+                count *= module.arrayLength(*type);
+                typeId = type->element;
+            }
+
+            reflection.bindings.push_back(DescriptorBinding{
+                .set = decorations.set.value_or(0),
+                .binding = *decorations.binding,
+                .type = descriptorType(module, typeId, variable.storageClass),
+                .count = count,
+                .stages = module.stage
+            });
+            break;
+        }
+        case StorageClassPushConstant:
+        {
+            const Type& block{ module.type(pointer.element) };
+            for(uint32_t i{ 0 }; i < block.members.size(); ++i)
+            {
+                const MemberDecorations& member{ module.memberDecoration(pointer.element, i) };
+                pushConstantsBegin = std::min(pushConstantsBegin, member.offset);
+                pushConstantsEnd = std::max(pushConstantsEnd, member.offset + module.size(block.members[i], member));
+            }
+            break;
+        }
+        case StorageClassInput:
+        {
+            // gl_VertexIndex and friends, and the gl_PerVertex block of later stages
+            if(module.executionModel != ExecutionModelVertex || decorations.builtIn || module.type(pointer.element).op == OpTypeStruct)
+                break;
+
+            if(!decorations.location)
+                throw std::runtime_error("Failure while reflecting shader: vertex input without a location");
+
+            reflection.vertexInputs.push_back(VertexInput{ .location = *decorations.location, .format = vertexFormat(module, pointer.element) });
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    if(pushConstantsEnd > 0)
+        reflection.pushConstants = VkPushConstantRange{ .stageFlags = module.stage, .offset = pushConstantsBegin, .size = pushConstantsEnd - pushConstantsBegin };
+
+    std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const auto& a, const auto& b) {
+        return std::tie(a.set, a.binding) < std::tie(b.set, b.binding);
+    });
+    std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [](const auto& a, const auto& b) { return a.location < b.location; });
+
+    return reflection;
+}
+
+ShaderReflection ShaderReflection::reflectFiles(std::initializer_list<std::filesystem::path> filepaths)
+{
+    std::vector<ShaderReflection> reflections;
+    for(const auto& filepath: filepaths)
+        reflections.push_back(reflect(Pipeline::readFile(filepath)));
+
+    return merge(reflections);
+}
+
+ShaderReflection ShaderReflection::merge(const std::vector<ShaderReflection>& reflections)
+{
+    ShaderReflection merged;
+
+    for(const auto& reflection: reflections)
+    {
+        merged.stages |= reflection.stages;
+
+        for(const auto& binding: reflection.bindings)
+        {
+            auto it{ std::find_if(merged.bindings.begin(), merged.bindings.end(), [&binding](const auto& existing) {
+                return existing.set == binding.set && existing.binding == binding.binding;
+            }) };
+
+            if(it == merged.bindings.end())
+                merged.bindings.push_back(binding);
+            else if(it->type != binding.type || it->count != binding.count)
+                throw std::runtime_error("Failure while merging shader reflections: set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding) + " differs between stages");
+            else
+                it->stages |= binding.stages;
+        }
+
+        const VkPushConstantRange& range{ reflection.pushConstants };
+        if(range.size > 0)
+        {
+            VkPushConstantRange& mergedRange{ merged.pushConstants };
+            if(mergedRange.size == 0)
+                mergedRange = range;
+            else
+            {
+                uint32_t end{ std::max(mergedRange.offset + mergedRange.size, range.offset + range.size) };
+                mergedRange.offset = std::min(mergedRange.offset, range.offset);
+                mergedRange.size = end - mergedRange.offset;
+                mergedRange.stageFlags |= range.stageFlags;
+            }
+        }
+
+        if(reflection.stages & VK_SHADER_STAGE_VERTEX_BIT)
+            merged.vertexInputs = reflection.vertexInputs;
+    }
+
+    std::sort(merged.bindings.begin(), merged.bindings.end(), [](const auto& a, const auto& b) {
+        return std::tie(a.set, a.binding) < std::tie(b.set, b.binding);
+    });
+
+    return merged;
+}
+
+void ShaderReflection::useDynamicOffsets(uint32_t set, uint32_t binding)
+{
+    for(auto& descriptor: bindings)
+    {
+        if(descriptor.set != set || descriptor.binding != binding)
+            continue;
+
+        if(descriptor.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+            descriptor.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        else if(descriptor.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+            descriptor.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        else if(descriptor.type != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC && descriptor.type != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+            throw std::runtime_error("Failure while using dynamic offsets: the binding is not a buffer");
+        return;
+    }
+
+    throw std::runtime_error("Failure while using dynamic offsets: set " + std::to_string(set) + " binding " + std::to_string(binding) + " is not used by the shaders");
+}
+
+uint32_t ShaderReflection::setCount() const
+{
+    return bindings.empty() ? 0 : bindings.back().set + 1;
+}
+
+std::vector<VkDescriptorSetLayoutBinding> ShaderReflection::setBindings(uint32_t set) const
+{
+    std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+    for(const auto& descriptor: bindings)
+    {
+        if(descriptor.set != set)
+            continue;
+
+        layoutBindings.push_back(VkDescriptorSetLayoutBinding{
+            .binding = descriptor.binding,
+            .descriptorType = descriptor.type,
+            .descriptorCount = descriptor.count,
+            .stageFlags = descriptor.stages
+        });
+    }
+    return layoutBindings;
+}
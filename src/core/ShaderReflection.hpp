@@ -0,0 +1,56 @@
+#ifndef CORE_SHADER_REFLECTION_HPP
+#define CORE_SHADER_REFLECTION_HPP
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <vector>
+
+/*
+ * The interface of one or more SPIR-V modules as far as the pipeline layout and the vertex input are concerned:
+ * descriptor bindings, the push constant range and the vertex shader inputs.
+ * Read straight from the module's types and decorations, no external library involved.
+ * SPIR-V doesn't know about dynamic offsets, buffers bound with one are marked through useDynamicOffsets.
+ */
+struct ShaderReflection
+{
+    struct DescriptorBinding
+    {
+        uint32_t set;
+        uint32_t binding;
+        VkDescriptorType type;
+        uint32_t count;
+        VkShaderStageFlags stages;
+    };
+
+    struct VertexInput
+    {
+        uint32_t location;
+        VkFormat format;
+    };
+
+    VkShaderStageFlags stages{ 0 };
+    // sorted by set and binding
+    std::vector<DescriptorBinding> bindings;
+    // one range over the push constants of every stage, size is 0 when no stage has any
+    VkPushConstantRange pushConstants{ 0, 0, 0 };
+    // vertex shader inputs sorted by location, built-ins are not listed
+    std::vector<VertexInput> vertexInputs;
+
+    static ShaderReflection reflect(const std::vector<char>& code);
+    // reads and merges the modules of one pipeline
+    static ShaderReflection reflectFiles(std::initializer_list<std::filesystem::path> filepaths);
+    // a binding used by several stages gets the stage flags of all of them
+    static ShaderReflection merge(const std::vector<ShaderReflection>& reflections);
+
+    // turns a uniform or storage buffer binding into its _DYNAMIC descriptor type
+    void useDynamicOffsets(uint32_t set, uint32_t binding);
+
+    // sets without bindings below the highest used one are counted, they get an empty layout
+    uint32_t setCount() const;
+    std::vector<VkDescriptorSetLayoutBinding> setBindings(uint32_t set) const;
+};
+
+#endif //!CORE_SHADER_REFLECTION_HPP
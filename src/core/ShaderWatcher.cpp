@@ -0,0 +1,96 @@
+#include "ShaderWatcher.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+ShaderWatcher::ShaderWatcher(const std::filesystem::path& directory)
+    : m_directory(directory)
+{
+#ifdef __linux__
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(m_inotify < 0)
+        throw std::runtime_error("Failure while initializing inotify");
+
+    // editors either write in place or write a temporary and rename it over the source
+    if(inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        close(m_inotify);
+        throw std::runtime_error("Failure while watching the shader directory: " + directory.string());
+    }
+#else
+    for(const auto& entry: std::filesystem::directory_iterator(directory))
+    {
+        if(isShaderSource(entry.path()))
+            m_lastWrite[entry.path().string()] = entry.last_write_time();
+    }
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+#ifdef __linux__
+    close(m_inotify);
+#endif
+}
+
+std::vector<std::filesystem::path> ShaderWatcher::poll()
+{
+    std::vector<std::filesystem::path> changed;
+
+#ifdef __linux__
+    alignas(inotify_event) std::array<char, 4096> buffer;
+
+    while(true)
+    {
+        ssize_t length{ read(m_inotify, buffer.data(), buffer.size()) };
+        if(length <= 0)
+        {
+            if(length < 0 && errno != EAGAIN && errno != EINTR)
+                throw std::runtime_error("Failure while reading inotify events");
+            break;
+        }
+
+        for(ssize_t offset{ 0 }; offset < length;)
+        {
+            const auto* event{ reinterpret_cast<const inotify_event*>(buffer.data() + offset) };
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if(event->len == 0)
+                continue;
+
+            std::filesystem::path path{ m_directory / event->name };
+            if(isShaderSource(path) && std::find(changed.begin(), changed.end(), path) == changed.end())
+                changed.push_back(path);
+        }
+    }
+#else
+    for(const auto& entry: std::filesystem::directory_iterator(m_directory))
+    {
+        if(!isShaderSource(entry.path()))
+            continue;
+
+        auto lastWrite{ entry.last_write_time() };
+        auto [it, inserted]{ m_lastWrite.try_emplace(entry.path().string(), lastWrite) };
+        if(inserted || it->second != lastWrite)
+        {
+            it->second = lastWrite;
+            changed.push_back(entry.path());
+        }
+    }
+#endif
+
+    return changed;
+}
+
+bool ShaderWatcher::isShaderSource(const std::filesystem::path& path)
+{
+    auto extension{ path.extension() };
+    return extension == ".vert" || extension == ".frag" || extension == ".comp";
+}
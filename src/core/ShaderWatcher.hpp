@@ -0,0 +1,40 @@
+#ifndef CORE_SHADER_WATCHER_HPP
+#define CORE_SHADER_WATCHER_HPP
+
+#include <filesystem>
+#include <vector>
+
+#ifndef __linux__
+#include <string>
+#include <unordered_map>
+#endif
+
+/*
+ * Reports shader sources (.vert, .frag, .comp) in a directory that were written since the last poll.
+ * Uses inotify on Linux, elsewhere it falls back to comparing modification times.
+ */
+class ShaderWatcher
+{
+public:
+    explicit ShaderWatcher(const std::filesystem::path& directory);
+    ~ShaderWatcher();
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    // never blocks, every source is listed at most once
+    std::vector<std::filesystem::path> poll();
+
+    static bool isShaderSource(const std::filesystem::path& path);
+
+private:
+    std::filesystem::path m_directory;
+
+#ifdef __linux__
+    int m_inotify{ -1 };
+#else
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_lastWrite;
+#endif
+};
+
+#endif //!CORE_SHADER_WATCHER_HPP
@@ -9,74 +9,245 @@
 #include <cstdint>
 #include <stdexcept>
 
-Swapchain::Swapchain(Device& device, VkExtent2D extent)
-    : device(device), m_windowExtent(extent)
+namespace
 {
-    createSwapchain();
+    uint32_t framesInFlightFor(PresentPolicy policy)
+    {
+        switch(policy)
+        {
+            case PresentPolicy::LowLatency: return 1;
+            case PresentPolicy::Throughput: return 3;
+            default: return 2;
+        }
+    }
+
+    // images on top of the surface's minimum, more images let the presentation engine queue up more frames
+    uint32_t extraImagesFor(PresentPolicy policy)
+    {
+        switch(policy)
+        {
+            case PresentPolicy::LowLatency: return 0;
+            case PresentPolicy::Throughput: return 2;
+            default: return 1;
+        }
+    }
+
+    // in order of preference, FIFO is always supported and is the last resort for every policy
+    std::vector<VkPresentModeKHR> presentModesFor(PresentPolicy policy)
+    {
+        switch(policy)
+        {
+            case PresentPolicy::LowLatency: return { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR };
+            case PresentPolicy::PowerSaving: return {};
+            default: return { VK_PRESENT_MODE_MAILBOX_KHR };
+        }
+    }
+}
+
+const char* toString(PresentPolicy policy)
+{
+    switch(policy)
+    {
+        case PresentPolicy::LowLatency: return "low-latency";
+        case PresentPolicy::Balanced: return "balanced";
+        case PresentPolicy::Throughput: return "throughput";
+        case PresentPolicy::PowerSaving: return "power-saving";
+    }
+
+    return "unknown";
+}
+
+std::optional<PresentPolicy> parsePresentPolicy(std::string_view name)
+{
+    for(auto policy: { PresentPolicy::LowLatency, PresentPolicy::Balanced, PresentPolicy::Throughput, PresentPolicy::PowerSaving })
+    {
+        if(name == toString(policy))
+            return policy;
+    }
+
+    return std::nullopt;
+}
+
+const char* toString(VkPresentModeKHR presentMode)
+{
+    switch(presentMode)
+    {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR: return "fifo";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo relaxed";
+        default: return "unknown";
+    }
+}
+
+Swapchain::Swapchain(Device& device, VkExtent2D extent, PresentPolicy policy)
+    : device(device), m_windowExtent(extent), m_policy(policy), m_framesInFlight(framesInFlightFor(policy))
+{
+    if(device.isHeadless())
+        createOffscreenImages();
+    else
+        createSwapchain(VK_NULL_HANDLE);
     createImageViews();
     createRenderPass();
-    createDepthResources();
+    createRenderTargets();
     createFramebuffers();
     createSyncObjects();
 }
 
 Swapchain::~Swapchain()
 {
-    for(auto imageView: m_swapchainImageViews)
-        vkDestroyImageView(device.device(), imageView, nullptr);
-    m_swapchainImageViews.clear();
+    RetiredResources current{ takeExtentResources() };
+    current.swapchain = m_swapchain;
+    current.renderPass = m_renderPass;
+    destroyRetired(current);
+
+    for(auto& retired: m_retired)
+        destroyRetired(retired);
+
+    for(size_t i{ 0 }; i < m_framesInFlight; ++i)
+    {
+        vkDestroySemaphore(device.device(), m_renderFinishedSemaphores[i], nullptr);
+        vkDestroySemaphore(device.device(), m_imageAvailableSemaphores[i], nullptr);
+        vkDestroyFence(device.device(), m_inFlightFences[i], nullptr);
+    }
+}
+
+void Swapchain::recreate(VkExtent2D windowExtent)
+{
+    m_windowExtent = windowExtent;
+    VkFormat oldFormat{ m_swapchainImageFormat };
 
-    if(m_swapchain != nullptr)
+    // no vkDeviceWaitIdle: the old resources stay alive until the frames that use them are done
+    RetiredResources retired{ takeExtentResources() };
+    retired.retiredAt = m_submittedFrames;
+
+    if(device.isHeadless())
+        createOffscreenImages();
+    else
     {
-        vkDestroySwapchainKHR(device.device(), m_swapchain, nullptr);
-        m_swapchain = nullptr;
+        // handing over the old swapchain lets its outstanding presents retire instead of being torn down
+        retired.swapchain = m_swapchain;
+        createSwapchain(retired.swapchain);
     }
 
-    for(size_t i{ 0 }; i < m_depthImages.size(); ++i)
+    if(m_swapchainImageFormat != oldFormat)
     {
-        vkDestroyImageView(device.device(), m_depthImageViews[i], nullptr);
-        vkDestroyImage(device.device(), m_depthImages[i], nullptr);
-        vkFreeMemory(device.device(), m_depthImageMemories[i], nullptr);
+        retired.renderPass = m_renderPass;
+        createRenderPass();
     }
 
-    for(auto framebuffer: m_swapchainFramebuffers)
+    createImageViews();
+    createRenderTargets();
+    createFramebuffers();
+
+    // the image count can change with the new swapchain
+    m_imagesInFlight.assign(imageCount(), VK_NULL_HANDLE);
+    m_retired.push_back(std::move(retired));
+}
+
+Swapchain::RetiredResources Swapchain::takeExtentResources()
+{
+    RetiredResources resources{
+        .framebuffers = std::move(m_swapchainFramebuffers),
+        .imageViews = std::move(m_swapchainImageViews),
+        .offscreenImages = device.isHeadless() ? std::move(m_swapchainImages) : std::vector<VkImage>{},
+        .offscreenImageMemories = std::move(m_offscreenImageMemories),
+        .renderTargets = std::move(m_renderTargets)
+    };
+
+    m_swapchainFramebuffers.clear();
+    m_swapchainImageViews.clear();
+    m_swapchainImages.clear();
+    m_offscreenImageMemories.clear();
+    m_renderTargets = RenderTargets{};
+
+    return resources;
+}
+
+void Swapchain::destroyRetired(RetiredResources& resources)
+{
+    for(auto framebuffer: resources.framebuffers)
         vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
 
-    vkDestroyRenderPass(device.device(), m_renderPass, nullptr);
+    for(auto imageView: resources.imageViews)
+        vkDestroyImageView(device.device(), imageView, nullptr);
 
-    for(size_t i{ 0 }; i < MAX_FRAMES_IN_FLIGHT; ++i)
-    {
-        vkDestroySemaphore(device.device(), m_renderFinishedSemaphores[i], nullptr);
-        vkDestroySemaphore(device.device(), m_imageAvailableSemaphores[i], nullptr);
-        vkDestroyFence(device.device(), m_inFlightFences[i], nullptr);
-    }
+    for(size_t i{ 0 }; i < resources.offscreenImages.size(); ++i)
+        device.destroyImage(resources.offscreenImages[i], resources.offscreenImageMemories[i]);
+
+    RenderGraph::destroyTargets(device, resources.renderTargets);
+
+    if(resources.renderPass != VK_NULL_HANDLE)
+        vkDestroyRenderPass(device.device(), resources.renderPass, nullptr);
+
+    if(resources.swapchain != VK_NULL_HANDLE)
+        vkDestroySwapchainKHR(device.device(), resources.swapchain, nullptr);
+}
+
+void Swapchain::releaseRetiredResources()
+{
+    // every frame slot has waited on its fence at least once since the resources were retired
+    std::erase_if(m_retired, [this](RetiredResources& resources) {
+        if(m_submittedFrames < resources.retiredAt + m_framesInFlight)
+            return false;
+
+        destroyRetired(resources);
+        return true;
+    });
 }
 
 VkResult Swapchain::acquireNextImage(uint32_t* imageIndex)
 {
+    auto waitStart{ std::chrono::steady_clock::now() };
     vkWaitForFences(device.device(), 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
+    m_lastFenceSignaled = std::chrono::steady_clock::now();
+    m_lastFenceWait = m_lastFenceSignaled - waitStart;
+
+    releaseRetiredResources();
+
+    if(device.isHeadless())
+    {
+        *imageIndex = m_nextOffscreenImage;
+        m_nextOffscreenImage = (m_nextOffscreenImage + 1) % static_cast<uint32_t>(imageCount());
+
+        return VK_SUCCESS;
+    }
 
     return vkAcquireNextImageKHR(device.device(), m_swapchain, UINT64_MAX, m_imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE, imageIndex);
 }
 
-VkResult Swapchain::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex)
+VkResult Swapchain::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex, VkSemaphore waitSemaphore, VkPipelineStageFlags waitStage)
 {
     if(m_imagesInFlight[*imageIndex] != VK_NULL_HANDLE)
         vkWaitForFences(device.device(), 1, &m_imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
     m_imagesInFlight[*imageIndex] = m_inFlightFences[m_currentFrame];
 
+    // offscreen images are not handed out by a presentation engine, there is nothing to wait on or to present
+    std::array<VkSemaphore, 2> waitSemaphores;
+    std::array<VkPipelineStageFlags, 2> waitStages;
+    uint32_t waitCount{ 0 };
+
+    if(!device.isHeadless())
+    {
+        waitSemaphores[waitCount] = m_imageAvailableSemaphores[m_currentFrame];
+        waitStages[waitCount++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    }
+
+    if(waitSemaphore != VK_NULL_HANDLE)
+    {
+        waitSemaphores[waitCount] = waitSemaphore;
+        waitStages[waitCount++] = waitStage;
+    }
 
-    std::array<VkSemaphore, 1> waitSemaphores{ m_imageAvailableSemaphores[m_currentFrame] };
-    std::array<VkPipelineStageFlags, 1> waitStages{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
     std::array<VkSemaphore, 1> signalSemaphores{ m_renderFinishedSemaphores[m_currentFrame] };
     VkSubmitInfo submitInfo{
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size()),
+        .waitSemaphoreCount = waitCount,
         .pWaitSemaphores = waitSemaphores.data(),
         .pWaitDstStageMask = waitStages.data(),
         .commandBufferCount = 1,
         .pCommandBuffers = buffers,
-        .signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size()),
+        .signalSemaphoreCount = device.isHeadless() ? 0u : static_cast<uint32_t>(signalSemaphores.size()),
         .pSignalSemaphores = signalSemaphores.data()
     };
 
@@ -84,6 +255,14 @@ VkResult Swapchain::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_
     if(vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, m_inFlightFences[m_currentFrame]) != VK_SUCCESS)
         throw std::runtime_error("Failure while submitting draw command buffer");
 
+    ++m_submittedFrames;
+
+    if(device.isHeadless())
+    {
+        m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
+        return VK_SUCCESS;
+    }
+
     std::array<VkSwapchainKHR, 1> swapchains{ m_swapchain };
     VkPresentInfoKHR presentInfo{
         .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
@@ -96,12 +275,12 @@ VkResult Swapchain::submitCommandBuffers(const VkCommandBuffer* buffers, uint32_
 
     auto result{ vkQueuePresentKHR(device.graphicsQueue(), &presentInfo) };
 
-    m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
 
     return result;
 }
 
-void Swapchain::createSwapchain()
+void Swapchain::createSwapchain(VkSwapchainKHR oldSwapchain)
 {
     SwapchainSupportDetails swapchainSupport{ device.getSwapchainSupport() };
 
@@ -109,14 +288,14 @@ void Swapchain::createSwapchain()
     VkPresentModeKHR presentMode{ chooseSwapPresentMode(swapchainSupport.presentModes) };
     VkExtent2D extent{ chooseSwapExtent(swapchainSupport.capabilities) };
 
-    uint32_t imageCount{ swapchainSupport.capabilities.minImageCount + 1 };
+    uint32_t imageCount{ swapchainSupport.capabilities.minImageCount + extraImagesFor(m_policy) };
     if(swapchainSupport.capabilities.maxImageCount > 0 && imageCount > swapchainSupport.capabilities.maxImageCount)
         imageCount = swapchainSupport.capabilities.maxImageCount;
 
     VkSwapchainCreateInfoKHR createInfo{
         .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
         .surface = device.surface(),
-        .minImageCount = swapchainSupport.capabilities.minImageCount,
+        .minImageCount = imageCount,
         .imageFormat = surfaceFormat.format,
         .imageColorSpace = surfaceFormat.colorSpace,
         .imageExtent = extent,
@@ -126,7 +305,7 @@ void Swapchain::createSwapchain()
         .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
         .presentMode = presentMode,
         .clipped = VK_TRUE,
-        .oldSwapchain = VK_NULL_HANDLE
+        .oldSwapchain = oldSwapchain
     };
 
     QueueFamilyIndices indices{ device.findPhysicalQueueFamilies() };
@@ -156,6 +335,39 @@ void Swapchain::createSwapchain()
     m_swapchainExtent = extent;
 }
 
+void Swapchain::createOffscreenImages()
+{
+    m_swapchainImageFormat = device.findSupportedFormat({VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM}, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+    m_swapchainExtent = m_windowExtent;
+
+    m_swapchainImages.resize(OFFSCREEN_IMAGE_COUNT);
+    m_offscreenImageMemories.resize(OFFSCREEN_IMAGE_COUNT);
+
+    for(uint32_t i{ 0 }; i < OFFSCREEN_IMAGE_COUNT; ++i)
+    {
+        VkImageCreateInfo imageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .flags = 0,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = m_swapchainImageFormat,
+            .extent = VkExtent3D{
+                .width = m_swapchainExtent.width,
+                .height = m_swapchainExtent.height,
+                .depth = 1
+            },
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+        };
+
+        device.createImageWithInfo(imageCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_swapchainImages[i], m_offscreenImageMemories[i]);
+    }
+}
+
 void Swapchain::createImageViews()
 {
     m_swapchainImageViews.resize(imageCount());
@@ -183,150 +395,64 @@ void Swapchain::createImageViews()
 
 void Swapchain::createRenderPass()
 {
-    VkAttachmentDescription depthAttachment{
-        .format = findDepthFormat(),
-        .samples = VK_SAMPLE_COUNT_1_BIT,
-        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-        .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-        .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-    };
-
-    VkAttachmentReference depthAttachmentRef{
-        .attachment = 1,
-        .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-    };
-
-    VkAttachmentDescription colorAttachment{
-        .format = getSwapchainImageFormat(),
-        .samples = VK_SAMPLE_COUNT_1_BIT,
-        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-        .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
-    };
-
-    VkAttachmentReference colorAttachmentRef{
-        .attachment = 0,
-        .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-    };
+    // the scene renders straight into the swapchain image, depth only lives inside the render pass
+    m_renderGraph = RenderGraph{};
+    RenderResource color{ m_renderGraph.importAttachment("color", getSwapchainImageFormat(),
+        device.isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VkClearValue{ .color = { 0.1f, 0.1f, 0.1f, 1.f } }) };
+    RenderResource depth{ m_renderGraph.createAttachment("depth", findDepthFormat(), VkClearValue{ .depthStencil = { 1.f, 0 } }) };
 
-    VkSubpassDescription subpass{
-        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
-        .colorAttachmentCount = 1,
-        .pColorAttachments = &colorAttachmentRef,
-        .pDepthStencilAttachment = &depthAttachmentRef
-    };
-
-    VkSubpassDependency dependency{
-        .srcSubpass = VK_SUBPASS_EXTERNAL,
-        .dstSubpass = 0,
-        .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-        .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-        .srcAccessMask = 0,
-        .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
-    };
-
-    std::array<VkAttachmentDescription, 2> attachments{ colorAttachment, depthAttachment };
-    VkRenderPassCreateInfo createInfo{
-        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-        .attachmentCount = static_cast<uint32_t>(attachments.size()),
-        .pAttachments = attachments.data(),
-        .subpassCount = 1,
-        .pSubpasses = &subpass,
-        .dependencyCount = 1,
-        .pDependencies = &dependency
-    };
+    m_renderGraph.addPass("scene").writeColor(color).writeDepth(depth);
 
-    if(vkCreateRenderPass(device.device(), &createInfo, nullptr, &m_renderPass) != VK_SUCCESS)
-        throw std::runtime_error("Failure while creating render pass");
+    m_renderPass = m_renderGraph.compile(device.device());
 }
 
 void Swapchain::createFramebuffers()
 {
-    m_swapchainFramebuffers.resize(imageCount());
+    m_swapchainFramebuffers.resize(m_framesInFlight * imageCount());
 
-    for(size_t i{ 0 }; i < imageCount(); ++i)
+    for(uint32_t frame{ 0 }; frame < m_framesInFlight; ++frame)
     {
-        std::array<VkImageView, 2> attachments{ m_swapchainImageViews[i], m_depthImageViews[i] };
-
-        VkExtent2D swapchainExtent{ getSwapchainExtent() };
-        VkFramebufferCreateInfo createInfo{
-            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-            .renderPass = m_renderPass,
-            .attachmentCount = static_cast<uint32_t>(attachments.size()),
-            .pAttachments = attachments.data(),
-            .width = swapchainExtent.width,
-            .height = swapchainExtent.height,
-            .layers = 1
-        };
+        for(size_t i{ 0 }; i < imageCount(); ++i)
+        {
+            std::vector<VkImageView> attachments{ m_renderGraph.framebufferAttachments(m_renderTargets, frame, { m_swapchainImageViews[i] }) };
+
+            VkExtent2D swapchainExtent{ getSwapchainExtent() };
+            VkFramebufferCreateInfo createInfo{
+                .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+                .renderPass = m_renderPass,
+                .attachmentCount = static_cast<uint32_t>(attachments.size()),
+                .pAttachments = attachments.data(),
+                .width = swapchainExtent.width,
+                .height = swapchainExtent.height,
+                .layers = 1
+            };
 
-        if(vkCreateFramebuffer(device.device(), &createInfo, nullptr, &m_swapchainFramebuffers[i]) != VK_SUCCESS)
-            throw std::runtime_error("Failure while creating framebuffers");
+            if(vkCreateFramebuffer(device.device(), &createInfo, nullptr, &m_swapchainFramebuffers[frame * imageCount() + i]) != VK_SUCCESS)
+                throw std::runtime_error("Failure while creating framebuffers");
+        }
     }
 }
 
-void Swapchain::createDepthResources()
+void Swapchain::createRenderTargets()
 {
-    VkFormat depthFormat{ findDepthFormat() };
-    VkExtent2D swapchainExtent{ getSwapchainExtent() };
-
-    m_depthImages.resize(imageCount());
-    m_depthImageMemories.resize(imageCount());
-    m_depthImageViews.resize(imageCount());
-
-    for(size_t i{ 0 }; i < imageCount(); ++i)
-    {
-        VkImageCreateInfo imageCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-            .flags = 0,
-            .imageType = VK_IMAGE_TYPE_2D,
-            .format = depthFormat,
-            .extent = VkExtent3D{
-                .width = swapchainExtent.width,
-                .height = swapchainExtent.height,
-                .depth = 1
-            },
-            .mipLevels = 1,
-            .arrayLayers = 1,
-            .samples = VK_SAMPLE_COUNT_1_BIT,
-            .tiling = VK_IMAGE_TILING_OPTIMAL,
-            .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
-        };
-
-        device.createImageWithInfo(imageCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_depthImages[i], m_depthImageMemories[i]);
-
-        VkImageViewCreateInfo imageViewCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-            .image = m_depthImages[i],
-            .viewType = VK_IMAGE_VIEW_TYPE_2D,
-            .format = depthFormat,
-            .subresourceRange = VkImageSubresourceRange{
-                .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
-                .baseMipLevel = 0,
-                .levelCount = 1,
-                .baseArrayLayer = 0,
-                .layerCount = 1
-            }
-        };
-
-        if(vkCreateImageView(device.device(), &imageViewCreateInfo, nullptr, &m_depthImageViews[i]) != VK_SUCCESS)
-            throw std::runtime_error("Failure while creating depth image views");
-    }
+    // a frame in flight is the only user of its copy, one per swapchain image would mostly sit idle
+    m_renderTargets = m_renderGraph.createTargets(device, getSwapchainExtent(), m_framesInFlight);
+
+    VkDeviceSize perCopy{ (m_renderTargets.bytes + m_renderTargets.aliasedBytes) / m_framesInFlight };
+    // against separate, unaliased images for every swapchain image
+    VkDeviceSize perImageBytes{ perCopy * imageCount() };
+    VkDeviceSize saved{ perImageBytes > m_renderTargets.bytes ? perImageBytes - m_renderTargets.bytes : 0 };
+    std::clog << "Render targets: " << m_renderTargets.bytes / 1024 << " KiB for " << m_framesInFlight << " frames in flight" <<
+        (m_renderTargets.lazilyAllocated ? " (lazily allocated)" : "") << ", saving " << saved / 1024 << " KiB over a copy per swapchain image" << std::endl;
 }
 
 void Swapchain::createSyncObjects()
 {
-    m_imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    m_renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-    m_imagesInFlight.resize(MAX_FRAMES_IN_FLIGHT);
+    m_imageAvailableSemaphores.resize(m_framesInFlight);
+    m_renderFinishedSemaphores.resize(m_framesInFlight);
+    m_inFlightFences.resize(m_framesInFlight);
+    // indexed by image, several frames in flight can't render into the same image at once
+    m_imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
     VkSemaphoreCreateInfo semaphoreInfo{
         .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
@@ -337,7 +463,7 @@ void Swapchain::createSyncObjects()
         .flags = VK_FENCE_CREATE_SIGNALED_BIT
     };
 
-    for(size_t i{ 0 }; i < MAX_FRAMES_IN_FLIGHT; ++i)
+    for(size_t i{ 0 }; i < m_framesInFlight; ++i)
     {
         if(vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &m_imageAvailableSemaphores[i]) != VK_SUCCESS ||
             vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &m_renderFinishedSemaphores[i]) != VK_SUCCESS ||
@@ -361,17 +487,19 @@ VkSurfaceFormatKHR Swapchain::chooseSwapSurfcaeFormat(const std::vector<VkSurfac
 
 VkPresentModeKHR Swapchain::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes)
 {
-    for(const auto& presentMode: availablePresentModes)
+    m_presentMode = VK_PRESENT_MODE_FIFO_KHR;
+
+    for(auto preferred: presentModesFor(m_policy))
     {
-        if(presentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+        if(std::find(availablePresentModes.begin(), availablePresentModes.end(), preferred) != availablePresentModes.end())
         {
-            std::clog << "Present mode: Mailbox" << std::endl;
-            return presentMode;
+            m_presentMode = preferred;
+            break;
         }
     }
 
-    std::clog << "Present mode: V-Sync" << std::endl;
-    return VK_PRESENT_MODE_FIFO_KHR;
+    std::clog << "Present mode: " << toString(m_presentMode) << " (" << toString(m_policy) << ", " << m_framesInFlight << " frames in flight)" << std::endl;
+    return m_presentMode;
 }
 
 VkExtent2D Swapchain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities)
@@ -381,8 +509,8 @@ VkExtent2D Swapchain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilit
     else
     {
         VkExtent2D actualExtent{ m_windowExtent };
-        actualExtent.width = std::max(capabilities.minImageExtent.width, std::min(capabilities.minImageExtent.width, actualExtent.width));
-        actualExtent.height = std::max(capabilities.minImageExtent.height, std::min(capabilities.minImageExtent.height, actualExtent.height));
+        actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+        actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
 
         return actualExtent;
     }
@@ -2,68 +2,133 @@
 #define CORE_SWAPCHAIN_HPP
 
 #include "Device.hpp"
+#include "RenderGraph.hpp"
 
 #include <vulkan/vulkan_core.h>
 
+#include <chrono>
+#include <optional>
+#include <string_view>
 #include <vector>
 
+// trade-off between input latency, throughput and power, picks the frames in flight, present mode and image count
+enum class PresentPolicy
+{
+    // one frame in flight, IMMEDIATE or MAILBOX and the fewest images
+    LowLatency,
+    // two frames in flight, MAILBOX when available
+    Balanced,
+    // three frames in flight and extra images, so the CPU and GPU rarely wait on each other
+    Throughput,
+    // FIFO, the GPU idles until vblank instead of rendering frames that are never shown
+    PowerSaving
+};
+
+const char* toString(PresentPolicy policy);
+std::optional<PresentPolicy> parsePresentPolicy(std::string_view name);
+const char* toString(VkPresentModeKHR presentMode);
+
 class Swapchain
 {
 public:
-    static constexpr unsigned int MAX_FRAMES_IN_FLIGHT{ 2 };
+    static constexpr uint32_t OFFSCREEN_IMAGE_COUNT{ 3 };
 
-    Swapchain(Device& device, VkExtent2D windowExtent);
+    Swapchain(Device& device, VkExtent2D windowExtent, PresentPolicy policy = PresentPolicy::Balanced);
     ~Swapchain();
 
     Swapchain(const Swapchain&) = delete;
     void operator=(const Swapchain&) = delete;
 
-    VkFramebuffer getFramebuffer(size_t index) { return m_swapchainFramebuffers.at(index); }
+    // for the current frame in flight, its transient attachments are only reused once that frame's fence signaled
+    VkFramebuffer getFramebuffer(size_t index) { return m_swapchainFramebuffers.at(m_currentFrame * imageCount() + index); }
     VkRenderPass getRenderPass() { return m_renderPass; }
+    // in attachment order of the render pass
+    const std::vector<VkClearValue>& clearValues() { return m_renderGraph.clearValues(); }
+    const RenderGraph& renderGraph() { return m_renderGraph; }
     VkImageView getImageView(size_t index) { return m_swapchainImageViews.at(index); }
     size_t imageCount() { return m_swapchainImages.size(); }
     VkFormat getSwapchainImageFormat() { return m_swapchainImageFormat; }
     VkExtent2D getSwapchainExtent() { return m_swapchainExtent; }
     uint32_t width() { return m_swapchainExtent.width; }
     uint32_t height() { return m_swapchainExtent.height; }
+    size_t currentFrame() { return m_currentFrame; }
+    uint32_t framesInFlight() { return m_framesInFlight; }
+    PresentPolicy presentPolicy() { return m_policy; }
+    VkPresentModeKHR presentMode() { return m_presentMode; }
+    // time the last acquireNextImage spent waiting for the frame's fence
+    double lastFenceWaitMs() { return m_lastFenceWait.count(); }
+    // when that wait returned, the earliest point the frame's previous submission is known to be complete
+    std::chrono::steady_clock::time_point lastFenceSignaled() { return m_lastFenceSignaled; }
 
     float extentAspectRatio() { return static_cast<float>(m_swapchainExtent.width) / static_cast<float>(m_swapchainExtent.height); }
     VkFormat findDepthFormat();
 
     VkResult acquireNextImage(uint32_t* imageIndex);
-    VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
+    // waitSemaphore is an optional extra dependency, e.g. on work submitted to another queue
+    VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex, VkSemaphore waitSemaphore = VK_NULL_HANDLE, VkPipelineStageFlags waitStage = 0);
+
+    // rebuilds everything that depends on the extent, the render pass is kept unless the surface format changed
+    void recreate(VkExtent2D windowExtent);
 
 private:
+    // resources replaced by recreate(), destroyed once no frame in flight can reference them anymore
+    struct RetiredResources
+    {
+        uint64_t retiredAt{ 0 };
+        VkSwapchainKHR swapchain{ VK_NULL_HANDLE };
+        VkRenderPass renderPass{ VK_NULL_HANDLE };
+        std::vector<VkFramebuffer> framebuffers;
+        std::vector<VkImageView> imageViews;
+        std::vector<VkImage> offscreenImages;
+        std::vector<MemoryAllocation> offscreenImageMemories;
+        RenderTargets renderTargets;
+    };
+
     VkFormat m_swapchainImageFormat;
     VkExtent2D m_swapchainExtent;
 
     std::vector<VkFramebuffer> m_swapchainFramebuffers;
     VkRenderPass m_renderPass;
 
-    std::vector<VkImage> m_depthImages;
-    std::vector<VkDeviceMemory> m_depthImageMemories;
-    std::vector<VkImageView> m_depthImageViews;
+    // one copy of the transient attachments per frame in flight, the framebuffers are indexed by frame and then image
+    RenderGraph m_renderGraph;
+    RenderTargets m_renderTargets;
     std::vector<VkImage> m_swapchainImages;
     std::vector<VkImageView> m_swapchainImageViews;
+    // headless devices render into these instead of presentable images
+    std::vector<MemoryAllocation> m_offscreenImageMemories;
+    uint32_t m_nextOffscreenImage{ 0 };
 
     Device& device;
     VkExtent2D m_windowExtent;
+    PresentPolicy m_policy;
+    uint32_t m_framesInFlight;
+    VkPresentModeKHR m_presentMode{ VK_PRESENT_MODE_FIFO_KHR };
 
-    VkSwapchainKHR m_swapchain;
+    VkSwapchainKHR m_swapchain{ VK_NULL_HANDLE };
 
     std::vector<VkSemaphore> m_imageAvailableSemaphores;
     std::vector<VkSemaphore> m_renderFinishedSemaphores;
     std::vector<VkFence> m_inFlightFences;
     std::vector<VkFence> m_imagesInFlight;
     size_t m_currentFrame{ 0 };
+    uint64_t m_submittedFrames{ 0 };
+    std::vector<RetiredResources> m_retired;
+    std::chrono::duration<double, std::milli> m_lastFenceWait{ 0.0 };
+    std::chrono::steady_clock::time_point m_lastFenceSignaled;
 
-    void createSwapchain();
+    void createSwapchain(VkSwapchainKHR oldSwapchain);
+    void createOffscreenImages();
     void createImageViews();
-    void createDepthResources();
+    void createRenderTargets();
     void createRenderPass();
     void createFramebuffers();
     void createSyncObjects();
 
+    RetiredResources takeExtentResources();
+    void destroyRetired(RetiredResources& resources);
+    void releaseRetiredResources();
+
     VkSurfaceFormatKHR chooseSwapSurfcaeFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
     VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
     VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
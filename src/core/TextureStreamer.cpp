@@ -0,0 +1,527 @@
+#include "TextureStreamer.hpp"
+#include "Uploader.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+    constexpr uint32_t BYTES_PER_PIXEL{ 4 };
+
+    VkExtent2D levelExtent(VkExtent2D extent, uint32_t level)
+    {
+        return VkExtent2D{ std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u) };
+    }
+
+    VkImageSubresourceRange levelRange(uint32_t firstLevel, uint32_t levelCount)
+    {
+        return VkImageSubresourceRange{
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = firstLevel,
+            .levelCount = levelCount,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        };
+    }
+}
+
+TextureStreamer::TextureStreamer(Device& device, uint32_t framesInFlight, VkDeviceSize uploadBudget)
+    : device(device), m_framesInFlight(framesInFlight), m_uploadBudget(uploadBudget)
+{
+    // the mips are blitted with linear filtering, which has to be supported for the format
+    m_format = device.findSupportedFormat({ VK_FORMAT_R8G8B8A8_SRGB }, VK_IMAGE_TILING_OPTIMAL,
+        VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+
+    VkCommandPoolCreateInfo poolInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = device.findPhysicalQueueFamilies().graphicsFamily.value()
+    };
+
+    if(vkCreateCommandPool(device.device(), &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating texture command pool");
+
+    createSampler();
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    // copies into the images may still be queued or executing on the transfer queue
+    for(const auto& stream: m_streams)
+    {
+        if(stream.ticket != 0)
+            device.uploader().wait(stream.ticket);
+    }
+
+    if(m_recording.commandBuffer != VK_NULL_HANDLE)
+        submit();
+
+    for(auto& submission: m_pendingSubmissions)
+    {
+        vkWaitForFences(device.device(), 1, &submission.fence, VK_TRUE, UINT64_MAX);
+        m_freeSubmissions.push_back(submission);
+    }
+
+    for(auto& submission: m_freeSubmissions)
+        vkDestroyFence(device.device(), submission.fence, nullptr);
+
+    for(auto& [retiredAt, view]: m_retiredViews)
+        vkDestroyImageView(device.device(), view, nullptr);
+
+    for(auto& texture: m_textures)
+    {
+        if(texture.view != VK_NULL_HANDLE)
+            vkDestroyImageView(device.device(), texture.view, nullptr);
+
+        if(texture.image != VK_NULL_HANDLE)
+            device.destroyImage(texture.image, texture.memory);
+    }
+
+    vkDestroyCommandPool(device.device(), m_commandPool, nullptr);
+    vkDestroySampler(device.device(), m_sampler, nullptr);
+}
+
+TextureHandle TextureStreamer::load(std::filesystem::path path)
+{
+    TextureHandle handle{ static_cast<TextureHandle>(m_textures.size()) };
+    m_textures.emplace_back();
+
+    Stream& stream{ m_streams.emplace_back() };
+    stream.path = path;
+    stream.start = std::chrono::steady_clock::now();
+    stream.decode = m_decodePool.submit([path = std::move(path)]() { return decodeImage(path); });
+
+    return handle;
+}
+
+void TextureStreamer::update()
+{
+    ++m_updateCount;
+    retireSubmissions();
+    releaseRetiredViews();
+
+    // shared by every stream, earlier loads get their bytes first
+    VkDeviceSize budget{ m_uploadBudget };
+
+    for(size_t i{ 0 }; i < m_streams.size(); ++i)
+    {
+        Stream& stream{ m_streams[i] };
+        Texture& texture{ m_textures[i] };
+
+        switch(stream.stage)
+        {
+            case Stage::Decoding:
+                if(stream.decode.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                    break;
+
+                stream.image = stream.decode.get();
+                if(!stream.image.error.empty())
+                {
+                    std::cerr << "Failure while loading texture " << stream.path << ": " << stream.image.error << std::endl;
+                    stream.stage = Stage::Failed;
+                    break;
+                }
+
+                createImage(texture, stream.image);
+                uploadPreview(texture, stream);
+                stream.stage = Stage::UploadingPreview;
+                break;
+
+            case Stage::UploadingPreview:
+                if(!device.uploader().isComplete(stream.ticket))
+                    break;
+
+                recordMipChain(submissionCommandBuffer(), texture, stream.image.previewLevel, texture.mipLevels - 1);
+                stream.submission = m_recording.number;
+                stream.stage = Stage::GeneratingPreviewMips;
+                break;
+
+            case Stage::GeneratingPreviewMips:
+                if(stream.submission > m_completedSubmission)
+                    break;
+
+                setView(texture, stream.image.previewLevel);
+                stream.stage = stream.image.previewLevel == 0 ? Stage::Resident : Stage::StreamingBase;
+                break;
+
+            case Stage::StreamingBase:
+                budget -= streamBase(texture, stream, budget);
+                if(stream.uploadedRows == texture.extent.height)
+                    stream.stage = Stage::UploadingBase;
+                break;
+
+            case Stage::UploadingBase:
+                if(!device.uploader().isComplete(stream.ticket))
+                    break;
+
+                // the preview level is already resident, the blits stop right above it
+                recordMipChain(submissionCommandBuffer(), texture, 0, stream.image.previewLevel - 1);
+                stream.submission = m_recording.number;
+                stream.stage = Stage::GeneratingMips;
+                break;
+
+            case Stage::GeneratingMips:
+                if(stream.submission > m_completedSubmission)
+                    break;
+
+                setView(texture, 0);
+                stream.stage = Stage::Resident;
+                break;
+
+            default:
+                break;
+        }
+
+        if(stream.stage == Stage::Resident && !stream.image.pixels.empty())
+        {
+            std::chrono::duration<double, std::milli> elapsed{ std::chrono::steady_clock::now() - stream.start };
+            std::clog << "Texture " << stream.path << " (" << texture.extent.width << "x" << texture.extent.height << ", " << texture.mipLevels <<
+                " levels) resident after " << elapsed.count() << " ms" << std::endl;
+
+            stream.image = DecodedImage{};
+        }
+    }
+
+    if(m_recording.commandBuffer != VK_NULL_HANDLE)
+        submit();
+}
+
+size_t TextureStreamer::pendingCount() const
+{
+    return static_cast<size_t>(std::count_if(m_streams.begin(), m_streams.end(), [](const Stream& stream) {
+        return stream.stage != Stage::Resident && stream.stage != Stage::Failed;
+    }));
+}
+
+TextureStreamer::DecodedImage TextureStreamer::decodeImage(const std::filesystem::path& path)
+{
+    DecodedImage image;
+
+    int width, height, channels;
+    stbi_uc* pixels{ stbi_load(path.string().c_str(), &width, &height, &channels, STBI_rgb_alpha) };
+    if(!pixels)
+    {
+        image.error = stbi_failure_reason();
+        return image;
+    }
+
+    image.width = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    image.pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * BYTES_PER_PIXEL);
+    stbi_image_free(pixels);
+
+    VkExtent2D extent{ image.width, image.height };
+    while(std::max(extent.width, extent.height) >> image.previewLevel > PREVIEW_SIZE)
+        ++image.previewLevel;
+
+    image.previewExtent = levelExtent(extent, image.previewLevel);
+    if(image.previewLevel == 0)
+        return image;
+
+    // every preview texel averages its whole footprint in the base level, one pass over the pixels
+    uint32_t footprint{ 1u << image.previewLevel };
+    image.preview.resize(static_cast<size_t>(image.previewExtent.width) * image.previewExtent.height * BYTES_PER_PIXEL);
+
+    for(uint32_t py{ 0 }; py < image.previewExtent.height; ++py)
+    {
+        uint32_t y0{ py * footprint }, y1{ std::min(y0 + footprint, image.height) };
+
+        for(uint32_t px{ 0 }; px < image.previewExtent.width; ++px)
+        {
+            uint32_t x0{ px * footprint }, x1{ std::min(x0 + footprint, image.width) };
+            std::array<uint32_t, BYTES_PER_PIXEL> sum{};
+
+            for(uint32_t y{ y0 }; y < y1; ++y)
+            {
+                const uint8_t* row{ image.pixels.data() + (static_cast<size_t>(y) * image.width + x0) * BYTES_PER_PIXEL };
+                for(uint32_t x{ 0 }; x < (x1 - x0) * BYTES_PER_PIXEL; ++x)
+                    sum[x % BYTES_PER_PIXEL] += row[x];
+            }
+
+            uint32_t count{ std::max((x1 - x0) * (y1 - y0), 1u) };
+            uint8_t* texel{ image.preview.data() + (static_cast<size_t>(py) * image.previewExtent.width + px) * BYTES_PER_PIXEL };
+            for(uint32_t c{ 0 }; c < BYTES_PER_PIXEL; ++c)
+                texel[c] = static_cast<uint8_t>(sum[c] / count);
+        }
+    }
+
+    return image;
+}
+
+void TextureStreamer::createSampler()
+{
+    bool anisotropy{ device.enabledFeatures.samplerAnisotropy == VK_TRUE };
+
+    VkSamplerCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .mipLodBias = 0.f,
+        .anisotropyEnable = anisotropy ? VK_TRUE : VK_FALSE,
+        .maxAnisotropy = anisotropy ? std::min(16.f, device.properties.limits.maxSamplerAnisotropy) : 1.f,
+        .compareEnable = VK_FALSE,
+        .compareOp = VK_COMPARE_OP_ALWAYS,
+        // the views only cover the resident levels, so the sampler never has to clamp
+        .minLod = 0.f,
+        .maxLod = VK_LOD_CLAMP_NONE,
+        .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+        .unnormalizedCoordinates = VK_FALSE
+    };
+
+    if(vkCreateSampler(device.device(), &createInfo, nullptr, &m_sampler) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating texture sampler");
+}
+
+void TextureStreamer::createImage(Texture& texture, const DecodedImage& image)
+{
+    texture.extent = VkExtent2D{ image.width, image.height };
+    texture.mipLevels = static_cast<uint32_t>(std::bit_width(std::max(image.width, image.height)));
+    texture.residentLevel = texture.mipLevels;
+
+    VkImageCreateInfo imageCreateInfo{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .flags = 0,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = m_format,
+        .extent = VkExtent3D{
+            .width = image.width,
+            .height = image.height,
+            .depth = 1
+        },
+        .mipLevels = texture.mipLevels,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+    };
+
+    // written on the transfer queue and blitted on the graphics queue, no ownership transfers needed
+    const std::vector<uint32_t>& families{ device.resourceQueueFamilies() };
+    if(families.size() > 1)
+    {
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        imageCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(families.size());
+        imageCreateInfo.pQueueFamilyIndices = families.data();
+    }
+
+    device.createImageWithInfo(imageCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture.image, texture.memory);
+}
+
+void TextureStreamer::uploadPreview(Texture& texture, Stream& stream)
+{
+    const DecodedImage& image{ stream.image };
+    const std::vector<uint8_t>& pixels{ image.previewLevel == 0 ? image.pixels : image.preview };
+
+    VkBufferImageCopy region{
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource = VkImageSubresourceLayers{
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = image.previewLevel,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        },
+        .imageOffset = { 0, 0, 0 },
+        .imageExtent = { image.previewExtent.width, image.previewExtent.height, 1 }
+    };
+
+    device.uploader().prepareImage(texture.image, levelRange(0, texture.mipLevels));
+    stream.ticket = device.uploader().uploadImage(pixels.data(), pixels.size(), texture.image, region);
+
+    // staged on the spot, the CPU copy isn't needed anymore
+    stream.image.preview = {};
+}
+
+VkDeviceSize TextureStreamer::streamBase(Texture& texture, Stream& stream, VkDeviceSize budget)
+{
+    VkDeviceSize rowBytes{ static_cast<VkDeviceSize>(texture.extent.width) * BYTES_PER_PIXEL };
+
+    // what is left of the budget doesn't fit a row, unless nothing was spent yet, then a single row goes out anyway
+    if(budget < rowBytes && budget != m_uploadBudget)
+        return 0;
+
+    uint32_t remaining{ texture.extent.height - stream.uploadedRows };
+    uint32_t rows{ std::min(remaining, static_cast<uint32_t>(std::max<VkDeviceSize>(budget / rowBytes, 1))) };
+
+    VkBufferImageCopy region{
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource = VkImageSubresourceLayers{
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        },
+        .imageOffset = { 0, static_cast<int32_t>(stream.uploadedRows), 0 },
+        .imageExtent = { texture.extent.width, rows, 1 }
+    };
+
+    const uint8_t* data{ stream.image.pixels.data() + stream.uploadedRows * rowBytes };
+    stream.ticket = device.uploader().uploadImage(data, rows * rowBytes, texture.image, region);
+    stream.uploadedRows += rows;
+
+    return std::min(budget, rows * rowBytes);
+}
+
+void TextureStreamer::setView(Texture& texture, uint32_t baseLevel)
+{
+    VkImageViewCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = texture.image,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = m_format,
+        .subresourceRange = levelRange(baseLevel, texture.mipLevels - baseLevel)
+    };
+
+    VkImageView view;
+    if(vkCreateImageView(device.device(), &createInfo, nullptr, &view) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating texture image view");
+
+    if(texture.view != VK_NULL_HANDLE)
+        m_retiredViews.emplace_back(m_updateCount, texture.view);
+
+    texture.view = view;
+    texture.residentLevel = baseLevel;
+    ++texture.version;
+}
+
+void TextureStreamer::recordMipChain(VkCommandBuffer commandBuffer, const Texture& texture, uint32_t firstLevel, uint32_t lastLevel)
+{
+    VkImageMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = texture.image
+    };
+
+    // every level in the range was written by a copy or by the previous blit and is still TRANSFER_DST
+    auto toSource{ [&](uint32_t level) {
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.subresourceRange = levelRange(level, 1);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    } };
+
+    toSource(firstLevel);
+    for(uint32_t level{ firstLevel + 1 }; level <= lastLevel; ++level)
+    {
+        VkExtent2D src{ levelExtent(texture.extent, level - 1) };
+        VkExtent2D dst{ levelExtent(texture.extent, level) };
+
+        VkImageBlit blit{
+            .srcSubresource = VkImageSubresourceLayers{ .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = level - 1, .baseArrayLayer = 0, .layerCount = 1 },
+            .srcOffsets = { { 0, 0, 0 }, { static_cast<int32_t>(src.width), static_cast<int32_t>(src.height), 1 } },
+            .dstSubresource = VkImageSubresourceLayers{ .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = level, .baseArrayLayer = 0, .layerCount = 1 },
+            .dstOffsets = { { 0, 0, 0 }, { static_cast<int32_t>(dst.width), static_cast<int32_t>(dst.height), 1 } }
+        };
+
+        vkCmdBlitImage(commandBuffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+        toSource(level);
+    }
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.subresourceRange = levelRange(firstLevel, lastLevel - firstLevel + 1);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+VkCommandBuffer TextureStreamer::submissionCommandBuffer()
+{
+    if(m_recording.commandBuffer != VK_NULL_HANDLE)
+        return m_recording.commandBuffer;
+
+    if(m_freeSubmissions.empty())
+    {
+        Submission submission;
+        VkCommandBufferAllocateInfo allocInfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = m_commandPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1
+        };
+
+        if(vkAllocateCommandBuffers(device.device(), &allocInfo, &submission.commandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("Failure while allocating texture command buffer");
+
+        VkFenceCreateInfo fenceInfo{
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+        };
+
+        if(vkCreateFence(device.device(), &fenceInfo, nullptr, &submission.fence) != VK_SUCCESS)
+            throw std::runtime_error("Failure while creating texture fence");
+
+        m_freeSubmissions.push_back(submission);
+    }
+
+    m_recording = m_freeSubmissions.back();
+    m_freeSubmissions.pop_back();
+    m_recording.number = m_nextSubmission++;
+
+    VkCommandBufferBeginInfo beginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    };
+
+    vkResetCommandBuffer(m_recording.commandBuffer, 0);
+    if(vkBeginCommandBuffer(m_recording.commandBuffer, &beginInfo) != VK_SUCCESS)
+        throw std::runtime_error("Failure while begining to record texture command buffer");
+
+    return m_recording.commandBuffer;
+}
+
+void TextureStreamer::submit()
+{
+    if(vkEndCommandBuffer(m_recording.commandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failure while recording texture command buffer");
+
+    // the copies it reads were complete on the transfer queue before this was recorded, a fence wait ordered them
+    VkSubmitInfo submitInfo{
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &m_recording.commandBuffer
+    };
+
+    vkResetFences(device.device(), 1, &m_recording.fence);
+    if(vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, m_recording.fence) != VK_SUCCESS)
+        throw std::runtime_error("Failure while submitting texture mip generation");
+
+    m_pendingSubmissions.push_back(m_recording);
+    m_recording = Submission{};
+}
+
+void TextureStreamer::retireSubmissions()
+{
+    while(!m_pendingSubmissions.empty() && vkGetFenceStatus(device.device(), m_pendingSubmissions.front().fence) == VK_SUCCESS)
+    {
+        m_completedSubmission = m_pendingSubmissions.front().number;
+        m_freeSubmissions.push_back(m_pendingSubmissions.front());
+        m_pendingSubmissions.pop_front();
+    }
+}
+
+void TextureStreamer::releaseRetiredViews()
+{
+    // one extra update of slack, update() runs before the frame waits on its fence
+    while(!m_retiredViews.empty() && m_updateCount > m_retiredViews.front().first + m_framesInFlight)
+    {
+        vkDestroyImageView(device.device(), m_retiredViews.front().second, nullptr);
+        m_retiredViews.pop_front();
+    }
+}
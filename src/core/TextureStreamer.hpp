@@ -0,0 +1,158 @@
+#ifndef CORE_TEXTURE_STREAMER_HPP
+#define CORE_TEXTURE_STREAMER_HPP
+
+#include "Device.hpp"
+#include "MemoryAllocator.hpp"
+#include "ThreadPool.hpp"
+
+#include <vulkan/vulkan_core.h>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <utility>
+#include <vector>
+
+using TextureHandle = uint32_t;
+
+struct Texture
+{
+    VkImage image{ VK_NULL_HANDLE };
+    MemoryAllocation memory;
+    // covers the resident levels only, VK_NULL_HANDLE until the first of them arrived
+    VkImageView view{ VK_NULL_HANDLE };
+    VkExtent2D extent{ 0, 0 };
+    uint32_t mipLevels{ 0 };
+    // finest level that can be sampled, mipLevels while nothing is resident
+    uint32_t residentLevel{ 0 };
+    // bumped whenever view is replaced, descriptors written with an older view have to be written again
+    uint32_t version{ 0 };
+};
+
+/*
+ * Streams RGBA8 textures from image files without blocking the render thread.
+ * Files are decoded on the streamer's own threads, which also box filter a small preview level. A decode takes far
+ * longer than a frame, on the shared pool it would hold up the per frame parallelFor work queued behind it.
+ * The preview goes up first and the GPU blits the levels below it, so the texture can be sampled a few frames
+ * after its decode finished.
+ * The full resolution level then trickles through the uploader's staging ring within a per update byte budget,
+ * and once it landed the GPU blits the remaining levels and the view widens to the whole chain.
+ * Uploads go through the transfer queue, blits and layout transitions through the graphics queue, images are
+ * shared between the two families. Not thread safe, update() is meant to be driven once per frame.
+ */
+class TextureStreamer
+{
+public:
+    // largest side of the level that is decoded on the CPU and shown first
+    static constexpr uint32_t PREVIEW_SIZE{ 64 };
+    // staging bytes handed to the uploader per update, a huge texture takes a few frames instead of stalling one
+    static constexpr VkDeviceSize DEFAULT_UPLOAD_BUDGET{ 8ull * 1024 * 1024 };
+    // decodes are background work, few threads keep them from competing with the render loop's workers
+    static constexpr uint32_t DECODE_THREADS{ 2 };
+
+    TextureStreamer(Device& device, uint32_t framesInFlight, VkDeviceSize uploadBudget = DEFAULT_UPLOAD_BUDGET);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // returns right away, the texture has no view until its preview arrived
+    TextureHandle load(std::filesystem::path path);
+    // moves every texture along as far as it gets without waiting, call before the uploader's per frame flush
+    void update();
+
+    // valid until the next load
+    const Texture& texture(TextureHandle handle) const { return m_textures.at(handle); }
+    bool isResident(TextureHandle handle) const { return m_streams.at(handle).stage == Stage::Resident; }
+    // textures still decoding, uploading or generating mips
+    size_t pendingCount() const;
+    // trilinear and anisotropic, shared by every texture
+    VkSampler sampler() const { return m_sampler; }
+    VkFormat format() const { return m_format; }
+
+private:
+    enum class Stage
+    {
+        Decoding,
+        UploadingPreview,
+        GeneratingPreviewMips,
+        StreamingBase,
+        UploadingBase,
+        GeneratingMips,
+        Resident,
+        Failed
+    };
+
+    struct DecodedImage
+    {
+        uint32_t width{ 0 };
+        uint32_t height{ 0 };
+        std::vector<uint8_t> pixels;
+        uint32_t previewLevel{ 0 };
+        VkExtent2D previewExtent{ 0, 0 };
+        std::vector<uint8_t> preview;
+        std::string error;
+    };
+
+    struct Stream
+    {
+        std::filesystem::path path;
+        std::future<DecodedImage> decode;
+        DecodedImage image;
+        Stage stage{ Stage::Decoding };
+        // rows of the base level handed to the uploader so far
+        uint32_t uploadedRows{ 0 };
+        UploadTicket ticket{ 0 };
+        uint64_t submission{ 0 };
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // blits and layout transitions on the graphics queue, one per update that has any
+    struct Submission
+    {
+        VkCommandBuffer commandBuffer{ VK_NULL_HANDLE };
+        VkFence fence{ VK_NULL_HANDLE };
+        uint64_t number{ 0 };
+    };
+
+    Device& device;
+    uint32_t m_framesInFlight;
+    VkDeviceSize m_uploadBudget;
+    ThreadPool m_decodePool{ DECODE_THREADS };
+    VkFormat m_format;
+    VkSampler m_sampler;
+
+    std::vector<Texture> m_textures;
+    std::vector<Stream> m_streams;
+
+    VkCommandPool m_commandPool;
+    // the one being recorded this update, commandBuffer is VK_NULL_HANDLE when nothing needed the GPU yet
+    Submission m_recording;
+    std::vector<Submission> m_freeSubmissions;
+    std::deque<Submission> m_pendingSubmissions;
+    uint64_t m_nextSubmission{ 1 };
+    uint64_t m_completedSubmission{ 0 };
+
+    // views replaced while frames in flight may still sample them, stamped with the update they were retired at
+    std::deque<std::pair<uint64_t, VkImageView>> m_retiredViews;
+    uint64_t m_updateCount{ 0 };
+
+    static DecodedImage decodeImage(const std::filesystem::path& path);
+
+    void createSampler();
+    void createImage(Texture& texture, const DecodedImage& image);
+    void uploadPreview(Texture& texture, Stream& stream);
+    VkDeviceSize streamBase(Texture& texture, Stream& stream, VkDeviceSize budget);
+    void setView(Texture& texture, uint32_t baseLevel);
+    void recordMipChain(VkCommandBuffer commandBuffer, const Texture& texture, uint32_t firstLevel, uint32_t lastLevel);
+
+    VkCommandBuffer submissionCommandBuffer();
+    void submit();
+    void retireSubmissions();
+    void releaseRetiredViews();
+};
+
+#endif //!CORE_TEXTURE_STREAMER_HPP
@@ -0,0 +1,101 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <exception>
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    m_workers.reserve(threadCount);
+    for(uint32_t i{ 0 }; i < threadCount; ++i)
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_stopping = true;
+    }
+
+    m_condition.notify_all();
+
+    for(auto& worker: m_workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t)>& task)
+{
+    if(count == 0)
+        return;
+
+    std::vector<std::future<void>> pending;
+    pending.reserve(count - 1);
+
+    for(uint32_t i{ 1 }; i < count; ++i)
+        pending.push_back(submit([&task, i]() { task(i); }));
+
+    // every task has to be finished before an error leaves this scope, they all reference task
+    std::exception_ptr error;
+    try
+    {
+        task(0);
+    }
+    catch(...)
+    {
+        error = std::current_exception();
+    }
+
+    for(auto& future: pending)
+    {
+        try
+        {
+            future.get();
+        }
+        catch(...)
+        {
+            if(!error)
+                error = std::current_exception();
+        }
+    }
+
+    if(error)
+        std::rethrow_exception(error);
+}
+
+uint32_t ThreadPool::defaultThreadCount()
+{
+    uint32_t hardwareThreads{ std::thread::hardware_concurrency() };
+
+    return std::max(hardwareThreads, 2u) - 1;
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock{ m_mutex };
+        m_tasks.push(std::move(task));
+    }
+
+    m_condition.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+    while(true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+
+            if(m_stopping && m_tasks.empty())
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef CORE_THREAD_POOL_HPP
+#define CORE_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    // one core is left to the thread that feeds the pool
+    explicit ThreadPool(uint32_t threadCount = defaultThreadCount());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    uint32_t size() const { return static_cast<uint32_t>(m_workers.size()); }
+
+    template<typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<F>>;
+
+    // runs task(0) ... task(count - 1), the calling thread takes part and returns once all of them are done
+    // must not be called from inside a pool task, the caller would wait on its own queue
+    void parallelFor(uint32_t count, const std::function<void(uint32_t)>& task);
+
+    static uint32_t defaultThreadCount();
+
+private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping{ false };
+
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+};
+
+template<typename F>
+auto ThreadPool::submit(F&& task) -> std::future<std::invoke_result_t<F>>
+{
+    using Result = std::invoke_result_t<F>;
+
+    auto packaged{ std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task)) };
+    std::future<Result> future{ packaged->get_future() };
+
+    enqueue([packaged]() { (*packaged)(); });
+
+    return future;
+}
+
+#endif //!CORE_THREAD_POOL_HPP
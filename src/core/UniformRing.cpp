@@ -0,0 +1,87 @@
+#include "UniformRing.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+UniformRing::UniformRing(Device& device, uint32_t framesInFlight, VkDeviceSize blockSize, uint32_t blocksPerFrame)
+    : device(device), m_blockSize(blockSize)
+{
+    const VkPhysicalDeviceLimits& limits{ device.properties.limits };
+    if(blockSize > limits.maxUniformBufferRange)
+        throw std::runtime_error("Failure while creating uniform ring: block is larger than maxUniformBufferRange");
+
+    // every push takes a whole block, the descriptor's range always reads one
+    m_stride = alignUp(blockSize, std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, 1));
+    m_regionSize = m_stride * blocksPerFrame;
+
+    device.createBuffer(m_regionSize * framesInFlight, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_buffer, m_memory);
+
+    // host visible pages are mapped by the allocator for their whole lifetime
+    if(m_memory.mapped == nullptr)
+        throw std::runtime_error("Failure while creating uniform ring: memory is not mapped");
+
+    m_descriptorSet = device.descriptorAllocator().allocate(setLayout(device));
+
+    VkDescriptorBufferInfo bufferInfo{
+        .buffer = m_buffer,
+        .offset = 0,
+        .range = blockSize
+    };
+
+    VkWriteDescriptorSet write{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = m_descriptorSet,
+        .dstBinding = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .pBufferInfo = &bufferInfo
+    };
+
+    vkUpdateDescriptorSets(device.device(), 1, &write, 0, nullptr);
+}
+
+UniformRing::~UniformRing()
+{
+    device.destroyBuffer(m_buffer, m_memory);
+}
+
+VkDescriptorSetLayout UniformRing::setLayout(Device& device, VkShaderStageFlags stages)
+{
+    return device.descriptorLayouts().get({ VkDescriptorSetLayoutBinding{
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .descriptorCount = 1,
+        .stageFlags = stages
+    } });
+}
+
+void UniformRing::beginFrame(uint32_t frame)
+{
+    m_regionStart = m_regionSize * frame;
+    m_head = 0;
+}
+
+uint32_t UniformRing::push(const void* data, VkDeviceSize size)
+{
+    if(size > m_blockSize)
+        throw std::runtime_error("Failure while pushing uniform data: larger than the ring's block size");
+
+    VkDeviceSize offset{ m_head.fetch_add(m_stride) };
+    if(offset + m_stride > m_regionSize)
+        throw std::runtime_error("Failure while pushing uniform data: the frame's region is full");
+
+    VkDeviceSize dynamicOffset{ m_regionStart + offset };
+    std::memcpy(static_cast<char*>(m_memory.mapped) + dynamicOffset, data, size);
+
+    return static_cast<uint32_t>(dynamicOffset);
+}
@@ -0,0 +1,55 @@
+#ifndef CORE_UNIFORM_RING_HPP
+#define CORE_UNIFORM_RING_HPP
+
+#include "Device.hpp"
+#include "MemoryAllocator.hpp"
+
+#include <vulkan/vulkan_core.h>
+
+#include <atomic>
+#include <cstdint>
+
+/*
+ * Per draw uniform data without per draw buffers or per frame mapping.
+ * One host visible, coherent buffer is mapped once and split into a region per frame in flight,
+ * push() copies a block into the current frame's region and returns its dynamic offset.
+ * Every block is read through the same dynamic uniform buffer descriptor, so nothing is allocated while recording.
+ */
+class UniformRing
+{
+public:
+    UniformRing(Device& device, uint32_t framesInFlight, VkDeviceSize blockSize, uint32_t blocksPerFrame);
+    ~UniformRing();
+
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    // the layout of the set returned by descriptorSet(), binding 0 is the dynamic uniform buffer
+    static VkDescriptorSetLayout setLayout(Device& device, VkShaderStageFlags stages = VK_SHADER_STAGE_VERTEX_BIT);
+
+    // only once the frame's fence was waited on, the previous contents of its region are overwritten
+    void beginFrame(uint32_t frame);
+
+    // safe to call from several recording threads at once, size must not exceed the block size
+    uint32_t push(const void* data, VkDeviceSize size);
+
+    template<typename T>
+    uint32_t push(const T& data) { return push(&data, sizeof(T)); }
+
+    VkDescriptorSet descriptorSet() const { return m_descriptorSet; }
+
+private:
+    Device& device;
+    VkDeviceSize m_blockSize;
+    VkDeviceSize m_stride;
+    VkDeviceSize m_regionSize;
+
+    VkBuffer m_buffer;
+    MemoryAllocation m_memory;
+    VkDescriptorSet m_descriptorSet;
+
+    VkDeviceSize m_regionStart{ 0 };
+    std::atomic<VkDeviceSize> m_head{ 0 };
+};
+
+#endif //!CORE_UNIFORM_RING_HPP
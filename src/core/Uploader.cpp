@@ -0,0 +1,294 @@
+#include "Uploader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vulkan/vulkan_core.h>
+
+Uploader::Uploader(Device& device, VkDeviceSize ringSize)
+    : device(device), m_ringSize(ringSize)
+{
+    VkCommandPoolCreateInfo poolInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = device.findPhysicalQueueFamilies().transferFamily.value()
+    };
+
+    if(vkCreateCommandPool(device.device(), &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS)
+        throw std::runtime_error("Failure while creating upload command pool");
+
+    std::array<VkCommandBuffer, MAX_BATCHES_IN_FLIGHT> commandBuffers;
+    VkCommandBufferAllocateInfo allocInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = m_commandPool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = static_cast<uint32_t>(commandBuffers.size())
+    };
+
+    if(vkAllocateCommandBuffers(device.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+        throw std::runtime_error("Failure while allocating upload command buffers");
+
+    VkFenceCreateInfo fenceInfo{
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+    };
+
+    for(size_t i{ 0 }; i < m_batches.size(); ++i)
+    {
+        m_batches[i].commandBuffer = commandBuffers[i];
+
+        if(vkCreateFence(device.device(), &fenceInfo, nullptr, &m_batches[i].fence) != VK_SUCCESS)
+            throw std::runtime_error("Failure while creating upload fence");
+    }
+
+    device.createBuffer(m_ringSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_ringBuffer, m_ringMemory);
+}
+
+Uploader::~Uploader()
+{
+    flush();
+    while(!m_submittedBatches.empty())
+        waitForOldestBatch();
+
+    for(auto& batch: m_batches)
+    {
+        for(auto& [buffer, memory]: batch.transientBuffers)
+            device.destroyBuffer(buffer, memory);
+
+        vkDestroyFence(device.device(), batch.fence, nullptr);
+    }
+
+    vkDestroyCommandPool(device.device(), m_commandPool, nullptr);
+    device.destroyBuffer(m_ringBuffer, m_ringMemory);
+}
+
+UploadTicket Uploader::uploadBuffer(const void* data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dstOffset)
+{
+    VkDeviceSize srcOffset;
+    VkBuffer staging{ stage(data, size, srcOffset) };
+
+    Batch& batch{ currentBatch() };
+    VkBufferCopy region{
+        .srcOffset = srcOffset,
+        .dstOffset = dstOffset,
+        .size = size
+    };
+
+    vkCmdCopyBuffer(batch.commandBuffer, staging, dst, 1, &region);
+    ++batch.commandCount;
+
+    return batch.ticket;
+}
+
+UploadTicket Uploader::prepareImage(VkImage image, const VkImageSubresourceRange& range)
+{
+    Batch& batch{ currentBatch() };
+    VkImageMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = range
+    };
+
+    vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    ++batch.commandCount;
+
+    return batch.ticket;
+}
+
+UploadTicket Uploader::uploadImage(const void* data, VkDeviceSize size, VkImage image, VkBufferImageCopy region)
+{
+    VkBuffer staging{ stage(data, size, region.bufferOffset) };
+
+    Batch& batch{ currentBatch() };
+    vkCmdCopyBufferToImage(batch.commandBuffer, staging, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    ++batch.commandCount;
+
+    return batch.ticket;
+}
+
+UploadTicket Uploader::copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size)
+{
+    Batch& batch{ currentBatch() };
+    VkBufferCopy region{
+        .srcOffset = 0,
+        .dstOffset = 0,
+        .size = size
+    };
+
+    vkCmdCopyBuffer(batch.commandBuffer, src, dst, 1, &region);
+    ++batch.commandCount;
+
+    return batch.ticket;
+}
+
+UploadTicket Uploader::copyBufferToImage(VkBuffer buffer, VkImage image, const VkBufferImageCopy& region)
+{
+    Batch& batch{ currentBatch() };
+    vkCmdCopyBufferToImage(batch.commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    ++batch.commandCount;
+
+    return batch.ticket;
+}
+
+UploadTicket Uploader::flush()
+{
+    Batch& batch{ m_batches[m_currentBatch] };
+    if(!batch.recording)
+        return m_nextTicket - 1;
+
+    if(vkEndCommandBuffer(batch.commandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failure while recording upload command buffer");
+
+    VkSubmitInfo submitInfo{
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &batch.commandBuffer
+    };
+
+    vkResetFences(device.device(), 1, &batch.fence);
+    if(vkQueueSubmit(device.transferQueue(), 1, &submitInfo, batch.fence) != VK_SUCCESS)
+        throw std::runtime_error("Failure while submitting upload batch");
+
+    batch.ringHead = m_ringHead;
+    batch.recording = false;
+    m_submittedBatches.push_back(m_currentBatch);
+    m_currentBatch = (m_currentBatch + 1) % MAX_BATCHES_IN_FLIGHT;
+
+    return batch.ticket;
+}
+
+bool Uploader::isComplete(UploadTicket ticket)
+{
+    retire();
+
+    return ticket <= m_completedTicket;
+}
+
+void Uploader::wait(UploadTicket ticket)
+{
+    if(ticket <= m_completedTicket)
+        return;
+
+    const Batch& current{ m_batches[m_currentBatch] };
+    if(current.recording && current.ticket <= ticket)
+        flush();
+
+    while(ticket > m_completedTicket && !m_submittedBatches.empty())
+        waitForOldestBatch();
+}
+
+Uploader::Batch& Uploader::currentBatch()
+{
+    Batch& batch{ m_batches[m_currentBatch] };
+    if(batch.recording)
+        return batch;
+
+    // the slot is reused round robin, so it may still be executing
+    while(std::find(m_submittedBatches.begin(), m_submittedBatches.end(), m_currentBatch) != m_submittedBatches.end())
+        waitForOldestBatch();
+
+    VkCommandBufferBeginInfo beginInfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    };
+
+    vkResetCommandBuffer(batch.commandBuffer, 0);
+    if(vkBeginCommandBuffer(batch.commandBuffer, &beginInfo) != VK_SUCCESS)
+        throw std::runtime_error("Failure while begining to record upload command buffer");
+
+    batch.ticket = m_nextTicket++;
+    batch.commandCount = 0;
+    batch.recording = true;
+
+    return batch;
+}
+
+void Uploader::retire()
+{
+    while(!m_submittedBatches.empty())
+    {
+        Batch& batch{ m_batches[m_submittedBatches.front()] };
+        if(vkGetFenceStatus(device.device(), batch.fence) != VK_SUCCESS)
+            break;
+
+        for(auto& [buffer, memory]: batch.transientBuffers)
+            device.destroyBuffer(buffer, memory);
+        batch.transientBuffers.clear();
+
+        m_ringTail = batch.ringHead;
+        m_completedTicket = batch.ticket;
+        m_submittedBatches.pop_front();
+    }
+}
+
+void Uploader::waitForOldestBatch()
+{
+    if(m_submittedBatches.empty())
+        return;
+
+    vkWaitForFences(device.device(), 1, &m_batches[m_submittedBatches.front()].fence, VK_TRUE, UINT64_MAX);
+    retire();
+}
+
+VkBuffer Uploader::stage(const void* data, VkDeviceSize size, VkDeviceSize& offset)
+{
+    // big uploads would starve the ring, they get their own staging buffer that dies with the batch
+    if(size > m_ringSize / 2)
+    {
+        VkBuffer staging;
+        MemoryAllocation stagingMemory;
+        device.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging, stagingMemory);
+        std::memcpy(stagingMemory.mapped, data, size);
+
+        currentBatch().transientBuffers.emplace_back(staging, stagingMemory);
+        offset = 0;
+
+        return staging;
+    }
+
+    retire();
+    while(!reserve(size, offset))
+    {
+        // only the batch that is still recording holds on to ring memory
+        if(m_submittedBatches.empty())
+            flush();
+
+        if(m_submittedBatches.empty())
+            throw std::runtime_error("Failure while reserving staging memory");
+
+        waitForOldestBatch();
+    }
+
+    std::memcpy(static_cast<char*>(m_ringMemory.mapped) + offset, data, size);
+
+    return m_ringBuffer;
+}
+
+bool Uploader::reserve(VkDeviceSize size, VkDeviceSize& offset)
+{
+    uint64_t head{ m_ringHead };
+    VkDeviceSize ringOffset{ head % m_ringSize };
+    VkDeviceSize aligned{ (ringOffset + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT };
+
+    // a staging range never wraps around, the rest of the ring is skipped instead
+    if(aligned + size > m_ringSize)
+    {
+        head += m_ringSize - ringOffset;
+        aligned = 0;
+    }
+    else
+        head += aligned - ringOffset;
+
+    if(head + size - m_ringTail > m_ringSize)
+        return false;
+
+    m_ringHead = head + size;
+    offset = aligned;
+
+    return true;
+}
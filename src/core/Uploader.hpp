@@ -0,0 +1,85 @@
+#ifndef CORE_UPLOADER_HPP
+#define CORE_UPLOADER_HPP
+
+#include "Device.hpp"
+#include "MemoryAllocator.hpp"
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+/*
+ * Streams data to the GPU on the transfer queue.
+ * Data is staged through one persistently mapped ring buffer and all copies recorded until the next flush()
+ * end up in a single submit. Every call returns the ticket of the batch it was recorded into, the caller only
+ * waits on that ticket when it actually needs the data.
+ * The uploader is not thread safe, it is meant to be driven from the render thread.
+ */
+class Uploader
+{
+public:
+    static constexpr VkDeviceSize DEFAULT_RING_SIZE{ 32ull * 1024 * 1024 };
+    static constexpr VkDeviceSize STAGING_ALIGNMENT{ 16 };
+    static constexpr uint32_t MAX_BATCHES_IN_FLIGHT{ 4 };
+
+    Uploader(Device& device, VkDeviceSize ringSize = DEFAULT_RING_SIZE);
+    ~Uploader();
+
+    Uploader(const Uploader&) = delete;
+    Uploader& operator=(const Uploader&) = delete;
+
+    UploadTicket uploadBuffer(const void* data, VkDeviceSize size, VkBuffer dst, VkDeviceSize dstOffset = 0);
+    // moves the range to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, discarding its contents, ahead of the copies into it
+    UploadTicket prepareImage(VkImage image, const VkImageSubresourceRange& range);
+    // the image has to be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, region.bufferOffset is filled in by the uploader
+    UploadTicket uploadImage(const void* data, VkDeviceSize size, VkImage image, VkBufferImageCopy region);
+    UploadTicket copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size);
+    UploadTicket copyBufferToImage(VkBuffer buffer, VkImage image, const VkBufferImageCopy& region);
+
+    UploadTicket flush();
+    bool isComplete(UploadTicket ticket);
+    void wait(UploadTicket ticket);
+
+    VkDeviceSize ringSize() const { return m_ringSize; }
+    VkDeviceSize ringUsage() const { return m_ringHead - m_ringTail; }
+
+private:
+    struct Batch
+    {
+        VkCommandBuffer commandBuffer{ VK_NULL_HANDLE };
+        VkFence fence{ VK_NULL_HANDLE };
+        UploadTicket ticket{ 0 };
+        uint64_t ringHead{ 0 };
+        uint32_t commandCount{ 0 };
+        bool recording{ false };
+        std::vector<std::pair<VkBuffer, MemoryAllocation>> transientBuffers;
+    };
+
+    Device& device;
+    VkCommandPool m_commandPool;
+
+    VkBuffer m_ringBuffer;
+    MemoryAllocation m_ringMemory;
+    VkDeviceSize m_ringSize;
+    // monotonic byte positions, the ring offset is position % m_ringSize
+    uint64_t m_ringHead{ 0 };
+    uint64_t m_ringTail{ 0 };
+
+    std::array<Batch, MAX_BATCHES_IN_FLIGHT> m_batches;
+    std::deque<uint32_t> m_submittedBatches;
+    uint32_t m_currentBatch{ 0 };
+    UploadTicket m_nextTicket{ 1 };
+    UploadTicket m_completedTicket{ 0 };
+
+    Batch& currentBatch();
+    void retire();
+    void waitForOldestBatch();
+    VkBuffer stage(const void* data, VkDeviceSize size, VkDeviceSize& offset);
+    bool reserve(VkDeviceSize size, VkDeviceSize& offset);
+};
+
+#endif //!CORE_UPLOADER_HPP
@@ -10,11 +10,14 @@ Window::Window(int width, int height, const std::string& title)
         throw std::runtime_error("GLFW Failure while initializing GLFW");
 
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
     m_window = glfwCreateWindow(m_width, m_height, m_title.c_str(), nullptr, nullptr);
     if(!m_window)
         throw std::runtime_error("GLFW Failure while creating the window");
+
+    glfwSetWindowUserPointer(m_window, this);
+    glfwSetFramebufferSizeCallback(m_window, framebufferResizeCallback);
 }
 
 Window::~Window()
@@ -28,3 +31,11 @@ void Window::createWindowSurface(VkInstance& instance, VkSurfaceKHR* surface)
     if(glfwCreateWindowSurface(instance, m_window, nullptr, surface) != VK_SUCCESS)
         throw std::runtime_error("GLFW Failure while Creating Window Surface");
 }
+
+void Window::framebufferResizeCallback(GLFWwindow* window, int width, int height)
+{
+    auto self{ static_cast<Window*>(glfwGetWindowUserPointer(window)) };
+    self->m_framebufferResized = true;
+    self->m_width = width;
+    self->m_height = height;
+}
@@ -19,15 +19,20 @@ public:
     inline bool shouldClose() { return glfwWindowShouldClose(m_window); }
     inline VkExtent2D getExtent() { return { static_cast<uint32_t>(m_width), static_cast<uint32_t>(m_height) }; }
 
+    inline bool wasWindowResized() { return m_framebufferResized; }
+    inline void resetWindowResizedFlag() { m_framebufferResized = false; }
+
     void createWindowSurface(VkInstance& instance, VkSurfaceKHR* surface);
 
 private:
     GLFWwindow* m_window;
-    const int m_width;
-    const int m_height;
+    int m_width;
+    int m_height;
+    bool m_framebufferResized{ false };
     const std::string m_title;
 
     void initWindow();
+    static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
 };
 
 #endif // !WINDOW_HPP
@@ -1,15 +1,57 @@
 #include "core/Application.hpp"
 
+#include <cctype>
+#include <cstdlib>
 #include <exception>
 #include <iostream>
+#include <optional>
 #include <ostream>
+#include <string>
+#include <string_view>
 
-int main()
+int main(int argc, char* argv[])
 {
-    Application app{};
+    ApplicationConfig config{};
+
+    for(int i{ 1 }; i < argc; ++i)
+    {
+        std::string_view arg{ argv[i] };
+
+        if(arg == "--headless")
+        {
+            config.headless = true;
+
+            if(i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+                config.frameCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if(arg == "--stats" && i + 1 < argc)
+            config.statsPath = argv[++i];
+        else if(arg == "--cull-distance" && i + 1 < argc)
+            config.cullDistance = std::stof(argv[++i]);
+        else if(arg == "--indirect" && i + 1 < argc)
+            config.indirectObjectCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else if(arg == "--async-compute")
+            config.asyncCompute = true;
+        else if(arg == "--hot-reload")
+            config.hotReload = true;
+        else if(arg == "--texture" && i + 1 < argc)
+            config.texturePaths.emplace_back(argv[++i]);
+        else if(auto policy{ arg == "--present-policy" && i + 1 < argc ? parsePresentPolicy(argv[++i]) : std::nullopt })
+            config.presentPolicy = *policy;
+        else if(auto variant{ arg == "--variant" && i + 1 < argc ? PipelineVariants::find(argv[++i]) : std::nullopt })
+            config.variant = *variant;
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--headless [frames]] [--stats <file.csv|file.json>]" <<
+                " [--present-policy low-latency|balanced|throughput|power-saving] [--indirect <objects> [--async-compute]] [--cull-distance <distance>] [--hot-reload] [--texture <image>]..." <<
+                " [--variant opaque|culled|grayscale|unlit]" << std::endl;
+            return 1;
+        }
+    }
 
     try
     {
+        Application app{ config };
         app.run();
     }
     catch(const std::exception& e)